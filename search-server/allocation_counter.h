@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+//    operator new       .
+//    allocation_counter.cpp     
+// ;     ,      
+size_t GetThreadAllocationCount();
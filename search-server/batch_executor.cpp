@@ -0,0 +1,174 @@
+#include "batch_executor.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std::string_literals;
+
+thread_local BatchExecutor* BatchExecutor::current_executor_ = nullptr;
+thread_local size_t BatchExecutor::current_worker_ = 0;
+thread_local BatchExecutor::Batch* BatchExecutor::current_batch_ = nullptr;
+
+BatchExecutor::BatchExecutor(size_t thread_count) {
+    thread_count = std::max<size_t>(1, thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, i](std::stop_token stop_token) { RunWorker(stop_token, i); });
+    }
+}
+
+BatchExecutor::~BatchExecutor() {
+    for (std::jthread& thread : threads_) {
+        thread.request_stop();
+    }
+    wake_.notify_all();
+}
+
+void BatchExecutor::Run(size_t task_count, const std::function<void(size_t)>& task) {
+    if (task_count == 0) {
+        return;
+    }
+    Batch batch;
+    batch.task = &task;
+    //  32    - ,      
+    batch.grain_size = std::max<size_t>(1, task_count / (workers_.size() * 32));
+    batch.pending_task_count = 1;
+
+    const bool is_worker = current_executor_ == this;
+    Push(is_worker ? current_worker_ : 0, { &batch, 0, task_count, {} });
+    if (is_worker) {
+        //        ,   
+        Task next_task;
+        while (batch.pending_task_count.load(std::memory_order_acquire) != 0) {
+            if (TryPop(current_worker_, next_task)) {
+                Execute(current_worker_, std::move(next_task));
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+    std::unique_lock guard(batch.mutex);
+    batch.done.wait(guard, [&batch] {
+        return batch.pending_task_count.load(std::memory_order_acquire) == 0;
+        });
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+void BatchExecutor::Spawn(std::function<void()> task) {
+    if (current_executor_ != this || !current_batch_) {
+        throw std::logic_error("BatchExecutor::Spawn must be called from a task of this executor"s);
+    }
+    current_batch_->pending_task_count.fetch_add(1, std::memory_order_relaxed);
+    Push(current_worker_, { current_batch_, 0, 0, std::move(task) });
+}
+
+size_t BatchExecutor::GetThreadCount() const {
+    return workers_.size();
+}
+
+void BatchExecutor::Push(size_t worker, Task task) {
+    //    ,         
+    queued_task_count_.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard guard(workers_[worker]->mutex);
+        workers_[worker]->tasks.push_back(std::move(task));
+    }
+    //        
+    { std::lock_guard guard(sleep_mutex_); }
+    wake_.notify_one();
+}
+
+bool BatchExecutor::TryPop(size_t worker, Task& task) {
+    {
+        Worker& own = *workers_[worker];
+        std::lock_guard guard(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_task_count_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(worker + i) % workers_.size()];
+        std::lock_guard guard(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued_task_count_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchExecutor::Execute(size_t worker, Task task) {
+    Batch& batch = *task.batch;
+    Batch* const outer_batch = current_batch_;
+    current_batch_ = &batch;
+    try {
+        if (task.function) {
+            if (!batch.is_failed.load(std::memory_order_relaxed)) {
+                task.function();
+            }
+        }
+        else {
+            size_t end = task.end;
+            while (end - task.begin > batch.grain_size) {
+                const size_t middle = task.begin + (end - task.begin) / 2;
+                batch.pending_task_count.fetch_add(1, std::memory_order_relaxed);
+                Push(worker, { &batch, middle, end, {} });
+                end = middle;
+            }
+            for (size_t i = task.begin; i < end && !batch.is_failed.load(std::memory_order_relaxed); ++i) {
+                (*batch.task)(i);
+            }
+        }
+    }
+    catch (...) {
+        std::lock_guard guard(batch.mutex);
+        if (!batch.error) {
+            batch.error = std::current_exception();
+        }
+        batch.is_failed = true;
+    }
+    current_batch_ = outer_batch;
+    FinishTask(batch);
+}
+
+void BatchExecutor::FinishTask(Batch& batch) {
+    size_t pending_task_count = batch.pending_task_count.load(std::memory_order_relaxed);
+    while (pending_task_count > 1) {
+        if (batch.pending_task_count.compare_exchange_weak(pending_task_count, pending_task_count - 1,
+            std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            return;
+        }
+    }
+    //      :   Run,  ,
+    //        ,    
+    std::lock_guard guard(batch.mutex);
+    if (batch.pending_task_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        batch.done.notify_all();
+    }
+}
+
+void BatchExecutor::RunWorker(std::stop_token stop_token, size_t worker) {
+    current_executor_ = this;
+    current_worker_ = worker;
+    Task task;
+    while (!stop_token.stop_requested()) {
+        if (TryPop(worker, task)) {
+            Execute(worker, std::move(task));
+            continue;
+        }
+        std::unique_lock guard(sleep_mutex_);
+        wake_.wait(guard, stop_token, [this] {
+            return queued_task_count_.load(std::memory_order_acquire) != 0;
+            });
+    }
+}
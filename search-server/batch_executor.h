@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+//        .  
+//   :     ,   
+//      .    
+//    ,      .
+class BatchExecutor {
+public:
+    explicit BatchExecutor(size_t thread_count = std::max(1u, std::thread::hardware_concurrency()));
+
+    BatchExecutor(const BatchExecutor&) = delete;
+
+    BatchExecutor& operator=(const BatchExecutor&) = delete;
+
+    ~BatchExecutor();
+
+    //  task(i)   i  [0, task_count)      
+    //  .       .
+    //      .
+    void Run(size_t task_count, const std::function<void(size_t)>& task);
+
+    //    ,     .
+    //     
+    void Spawn(std::function<void()> task);
+
+    size_t GetThreadCount() const;
+
+private:
+    struct Batch {
+        const std::function<void(size_t)>* task = nullptr;
+        //  ,    
+        size_t grain_size = 1;
+        std::atomic<size_t> pending_task_count = 0;
+        std::atomic<bool> is_failed = false;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+
+    //  [begin, end)      
+    struct Task {
+        Batch* batch = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+        std::function<void()> function;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> queued_task_count_ = 0;
+    std::mutex sleep_mutex_;
+    std::condition_variable_any wake_;
+
+    static thread_local BatchExecutor* current_executor_;
+    static thread_local size_t current_worker_;
+    static thread_local Batch* current_batch_;
+
+    //   :  ,    
+    std::vector<std::jthread> threads_;
+
+    void Push(size_t worker, Task task);
+
+    bool TryPop(size_t worker, Task& task);
+
+    void Execute(size_t worker, Task task);
+
+    void FinishTask(Batch& batch);
+
+    void RunWorker(std::stop_token stop_token, size_t worker);
+};
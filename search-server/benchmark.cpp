@@ -0,0 +1,444 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <execution>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <sstream>
+
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+#include "string_processing.h"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+//        
+class StreamSilencer {
+public:
+    explicit StreamSilencer(std::ostream& stream)
+        : stream_(stream)
+        , buffer_(stream.rdbuf(nullptr)) {
+    }
+
+    ~StreamSilencer() {
+        stream_.rdbuf(buffer_);
+        stream_.clear();
+    }
+
+private:
+    std::ostream& stream_;
+    std::streambuf* const buffer_;
+};
+
+std::discrete_distribution<int> MakeWordDistribution(size_t word_count, double zipf_skew) {
+    std::vector<double> weights(word_count);
+    for (size_t rank = 0; rank < word_count; ++rank) {
+        weights[rank] = 1.0 / std::pow(static_cast<double>(rank + 1), zipf_skew);
+    }
+    return std::discrete_distribution<int>(weights.begin(), weights.end());
+}
+
+BenchmarkResult MakeBenchmarkResult(std::string_view name, size_t operation_count, std::vector<double> times,
+    const std::array<std::optional<double>, PerfCounters::EVENT_COUNT>& perf_counter_sums) {
+    BenchmarkResult result;
+    result.name = std::string(name);
+    result.operation_count = operation_count;
+    result.repetition_count = static_cast<int>(times.size());
+    if (times.empty()) {
+        return result;
+    }
+    const double operations = static_cast<double>(std::max<size_t>(1, operation_count)) * times.size();
+    for (size_t event = 0; event < PerfCounters::EVENT_COUNT; ++event) {
+        if (perf_counter_sums[event]) {
+            result.perf_counters[event] = *perf_counter_sums[event] / operations;
+        }
+    }
+    std::sort(times.begin(), times.end());
+    result.min_ns = times.front();
+    result.max_ns = times.back();
+    result.median_ns = times.size() % 2 == 1
+        ? times[times.size() / 2]
+        : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2.0;
+    result.mean_ns = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+    return result;
+}
+
+// setup      , operation 
+// operation_count .  perf_counters,  , 
+//   ; ,     ,  
+template <typename Setup, typename Operation>
+BenchmarkResult RunBenchmark(std::string_view name, const BenchmarkOptions& options, PerfCounters* perf_counters,
+    size_t operation_count, Setup setup, Operation operation) {
+    std::vector<double> times;
+    times.reserve(options.repetition_count);
+    std::array<std::optional<double>, PerfCounters::EVENT_COUNT> perf_counter_sums;
+    if (perf_counters) {
+        perf_counter_sums.fill(0.0);
+    }
+    for (int repetition = 0; repetition < options.warmup_count + options.repetition_count; ++repetition) {
+        setup();
+        if (perf_counters) {
+            perf_counters->Start();
+        }
+        const Clock::time_point start_time = Clock::now();
+        operation();
+        const Clock::duration duration = Clock::now() - start_time;
+        const PerfCounters::Values values = perf_counters ? perf_counters->Stop() : PerfCounters::Values{};
+        if (repetition < options.warmup_count) {
+            continue;
+        }
+        times.push_back(std::chrono::duration<double, std::nano>(duration).count() / std::max<size_t>(1, operation_count));
+        for (size_t event = 0; event < PerfCounters::EVENT_COUNT; ++event) {
+            if (perf_counter_sums[event] && values[event]) {
+                *perf_counter_sums[event] += static_cast<double>(*values[event]);
+            }
+            else {
+                perf_counter_sums[event].reset();
+            }
+        }
+    }
+    return MakeBenchmarkResult(name, operation_count, std::move(times), perf_counter_sums);
+}
+
+std::unique_ptr<SearchServer> MakeServer(const Corpus& corpus) {
+    auto search_server = std::make_unique<SearchServer>(corpus.stop_words);
+    std::vector<NewDocument> new_documents;
+    new_documents.reserve(corpus.documents.size());
+    for (size_t i = 0; i < corpus.documents.size(); ++i) {
+        new_documents.push_back({ static_cast<int>(i), corpus.documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    search_server->AddDocuments(std::execution::par, new_documents);
+    return search_server;
+}
+
+//      .  GCC  Clang 
+//   ,      ;  
+//        volatile-
+template <typename T>
+void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void* volatile sink = nullptr;
+    sink = &value;
+    static_cast<void>(sink);
+#endif
+}
+
+std::string_view FindJsonValue(std::string_view line, std::string_view key) {
+    const std::string pattern = "\""s + std::string(key) + "\":"s;
+    const size_t pos = line.find(pattern);
+    if (pos == std::string_view::npos) {
+        return {};
+    }
+    line.remove_prefix(pos + pattern.size());
+    if (!line.empty() && line.front() == '"') {
+        line.remove_prefix(1);
+        return line.substr(0, line.find('"'));
+    }
+    return line.substr(0, line.find_first_of(",}"sv));
+}
+
+}  // namespace
+
+std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(static_cast<char>(std::uniform_int_distribution<int>('a', 'z')(generator)));
+    }
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    std::shuffle(words.begin(), words.end(), generator);
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    std::discrete_distribution<int>& word_distribution, int word_count, double minus_word_ratio) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution(0.0, 1.0)(generator) < minus_word_ratio) {
+            query.push_back('-');
+        }
+        query += dictionary[word_distribution(generator)];
+    }
+    return query;
+}
+
+Corpus GenerateCorpus(const CorpusOptions& options) {
+    std::mt19937 generator(options.seed);
+    Corpus corpus;
+    corpus.dictionary = GenerateDictionary(generator, options.vocabulary_size, options.max_word_length);
+    corpus.stop_words = corpus.dictionary.front();
+    std::discrete_distribution<int> word_distribution = MakeWordDistribution(corpus.dictionary.size(), options.zipf_skew);
+    corpus.documents.reserve(options.document_count);
+    for (int i = 0; i < options.document_count; ++i) {
+        corpus.documents.push_back(GenerateQuery(generator, corpus.dictionary, word_distribution, options.document_word_count));
+    }
+    corpus.queries.reserve(options.query_count);
+    for (int i = 0; i < options.query_count; ++i) {
+        corpus.queries.push_back(GenerateQuery(generator, corpus.dictionary, word_distribution, options.query_word_count,
+            options.minus_word_ratio));
+    }
+    return corpus;
+}
+
+std::vector<BenchmarkResult> RunBenchmarks(const Corpus& corpus, const BenchmarkOptions& options) {
+    std::optional<PerfCounters> available_perf_counters;
+    if (options.collect_perf_counters) {
+        available_perf_counters.emplace();
+        if (!available_perf_counters->IsAvailable()) {
+            std::cerr << "Performance counters are unavailable, measuring time only"sv << std::endl;
+            available_perf_counters.reset();
+        }
+    }
+    PerfCounters* const perf_counters = available_perf_counters ? &*available_perf_counters : nullptr;
+
+    std::vector<BenchmarkResult> results;
+    const size_t document_count = corpus.documents.size();
+    const size_t query_count = corpus.queries.size();
+    std::unique_ptr<SearchServer> search_server;
+
+    results.push_back(RunBenchmark("AddDocument"sv, options, perf_counters, document_count,
+        [&] { search_server = std::make_unique<SearchServer>(corpus.stop_words); },
+        [&] {
+            for (size_t i = 0; i < document_count; ++i) {
+                search_server->AddDocument(static_cast<int>(i), corpus.documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+            }
+        }));
+
+    results.push_back(RunBenchmark("AddDocuments/par"sv, options, perf_counters, document_count,
+        [&] { search_server.reset(); },
+        [&] { search_server = MakeServer(corpus); }));
+
+    //    ,      
+    results.push_back(RunBenchmark("RemoveDocument"sv, options, perf_counters, (document_count + 1) / 2,
+        [&] { search_server = MakeServer(corpus); },
+        [&] {
+            for (size_t i = 0; i < document_count; i += 2) {
+                search_server->RemoveDocument(static_cast<int>(i));
+            }
+        }));
+
+    search_server = MakeServer(corpus);
+    const SearchServer& server = *search_server;
+    auto no_setup = [] {};
+
+    results.push_back(RunBenchmark("FindTopDocuments/seq"sv, options, perf_counters, query_count, no_setup, [&] {
+        for (const std::string& query : corpus.queries) {
+            DoNotOptimize(server.FindTopDocuments(std::execution::seq, query));
+        }
+        }));
+    results.push_back(RunBenchmark("FindTopDocuments/par"sv, options, perf_counters, query_count, no_setup, [&] {
+        for (const std::string& query : corpus.queries) {
+            DoNotOptimize(server.FindTopDocuments(std::execution::par, query));
+        }
+        }));
+    SearchServer::QueryContext context;
+    results.push_back(RunBenchmark("FindTopDocuments/context"sv, options, perf_counters, query_count, no_setup, [&] {
+        for (const std::string& query : corpus.queries) {
+            DoNotOptimize(server.FindTopDocuments(context, std::execution::seq, query));
+        }
+        }));
+
+    results.push_back(RunBenchmark("MatchDocument/seq"sv, options, perf_counters, query_count, no_setup, [&] {
+        for (size_t i = 0; i < query_count; ++i) {
+            DoNotOptimize(server.MatchDocument(std::execution::seq, corpus.queries[i], static_cast<int>(i % document_count)));
+        }
+        }));
+    results.push_back(RunBenchmark("MatchDocument/par"sv, options, perf_counters, query_count, no_setup, [&] {
+        for (size_t i = 0; i < query_count; ++i) {
+            DoNotOptimize(server.MatchDocument(std::execution::par, corpus.queries[i], static_cast<int>(i % document_count)));
+        }
+        }));
+
+    results.push_back(RunBenchmark("ProcessQueries"sv, options, perf_counters, query_count, no_setup, [&] {
+        DoNotOptimize(ProcessQueries(server, corpus.queries));
+        }));
+
+    //       id   
+    results.push_back(RunBenchmark("RemoveDuplicates"sv, options, perf_counters, document_count + (document_count + 9) / 10,
+        [&] {
+            search_server = MakeServer(corpus);
+            std::vector<std::string_view> words;
+            for (size_t i = 0; i < document_count; i += 10) {
+                SplitIntoWords(corpus.documents[i], words);
+                std::reverse(words.begin(), words.end());
+                std::string text;
+                for (const std::string_view word : words) {
+                    text += word;
+                    text.push_back(' ');
+                }
+                search_server->AddDocument(static_cast<int>(document_count + i), text, DocumentStatus::ACTUAL, { 1 });
+            }
+        },
+        [&] {
+            StreamSilencer silencer(std::cout);
+            RemoveDuplicates(*search_server);
+        }));
+    return results;
+}
+
+void WriteBenchmarkJson(std::ostream& out, const CorpusOptions& corpus_options, const BenchmarkOptions& options,
+    const std::vector<BenchmarkResult>& results) {
+    out << "{\n"sv
+        << "  \"corpus\": {\"vocabulary_size\":"sv << corpus_options.vocabulary_size
+        << ",\"max_word_length\":"sv << corpus_options.max_word_length
+        << ",\"zipf_skew\":"sv << corpus_options.zipf_skew
+        << ",\"document_count\":"sv << corpus_options.document_count
+        << ",\"document_word_count\":"sv << corpus_options.document_word_count
+        << ",\"query_count\":"sv << corpus_options.query_count
+        << ",\"query_word_count\":"sv << corpus_options.query_word_count
+        << ",\"minus_word_ratio\":"sv << corpus_options.minus_word_ratio
+        << ",\"seed\":"sv << corpus_options.seed << "},\n"sv
+        << "  \"warmup_count\": "sv << options.warmup_count << ",\n"sv
+        << "  \"repetition_count\": "sv << options.repetition_count << ",\n"sv
+        << "  \"benchmarks\": [\n"sv;
+    //     ,    ReadBenchmarkJson
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        out << "    {\"name\":\""sv << result.name << "\",\"operation_count\":"sv << result.operation_count
+            << ",\"repetition_count\":"sv << result.repetition_count
+            << std::fixed << std::setprecision(1)
+            << ",\"min_ns\":"sv << result.min_ns << ",\"median_ns\":"sv << result.median_ns
+            << ",\"mean_ns\":"sv << result.mean_ns << ",\"max_ns\":"sv << result.max_ns;
+        bool has_perf_counters = false;
+        for (size_t event = 0; event < PerfCounters::EVENT_COUNT; ++event) {
+            if (!result.perf_counters[event]) {
+                continue;
+            }
+            out << (has_perf_counters ? ","sv : ",\"perf_counters\":{"sv)
+                << '"' << PerfCounters::GetEventName(static_cast<PerfCounters::Event>(event)) << "\":"sv
+                << std::setprecision(3) << *result.perf_counters[event];
+            has_perf_counters = true;
+        }
+        out << (has_perf_counters ? "}}"sv : "}"sv) << (i + 1 < results.size() ? ","sv : ""sv) << '\n';
+        out.unsetf(std::ios_base::floatfield);
+    }
+    out << "  ]\n}"sv << std::endl;
+}
+
+std::vector<BenchmarkResult> ReadBenchmarkJson(std::istream& in) {
+    std::vector<BenchmarkResult> results;
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::string_view name = FindJsonValue(line, "name"sv);
+        if (name.empty()) {
+            continue;
+        }
+        BenchmarkResult result;
+        result.name = std::string(name);
+        result.operation_count = std::stoull(std::string(FindJsonValue(line, "operation_count"sv)));
+        result.repetition_count = std::stoi(std::string(FindJsonValue(line, "repetition_count"sv)));
+        result.min_ns = std::stod(std::string(FindJsonValue(line, "min_ns"sv)));
+        result.median_ns = std::stod(std::string(FindJsonValue(line, "median_ns"sv)));
+        result.mean_ns = std::stod(std::string(FindJsonValue(line, "mean_ns"sv)));
+        result.max_ns = std::stod(std::string(FindJsonValue(line, "max_ns"sv)));
+        for (size_t event = 0; event < PerfCounters::EVENT_COUNT; ++event) {
+            const std::string_view value = FindJsonValue(line, PerfCounters::GetEventName(static_cast<PerfCounters::Event>(event)));
+            if (!value.empty()) {
+                result.perf_counters[event] = std::stod(std::string(value));
+            }
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+std::vector<BenchmarkComparison> CompareBenchmarks(const std::vector<BenchmarkResult>& baseline,
+    const std::vector<BenchmarkResult>& results, double threshold) {
+    std::vector<BenchmarkComparison> comparisons;
+    for (const BenchmarkResult& result : results) {
+        const auto it = std::find_if(baseline.begin(), baseline.end(), [&result](const BenchmarkResult& baseline_result) {
+            return baseline_result.name == result.name;
+            });
+        if (it == baseline.end() || it->median_ns <= 0.0) {
+            continue;
+        }
+        BenchmarkComparison comparison;
+        comparison.name = result.name;
+        comparison.baseline_ns = it->median_ns;
+        comparison.current_ns = result.median_ns;
+        comparison.change = result.median_ns / it->median_ns - 1.0;
+        comparison.is_regression = comparison.change > threshold;
+        comparisons.push_back(std::move(comparison));
+    }
+    return comparisons;
+}
+
+void PrintBenchmarkResults(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    out << std::left << std::setw(28) << "benchmark"sv << std::right << std::setw(10) << "ops"sv
+        << std::setw(14) << "median, ns"sv << std::setw(14) << "min, ns"sv << std::setw(14) << "max, ns"sv << std::endl;
+    out << std::fixed << std::setprecision(1);
+    for (const BenchmarkResult& result : results) {
+        out << std::left << std::setw(28) << result.name << std::right << std::setw(10) << result.operation_count
+            << std::setw(14) << result.median_ns << std::setw(14) << result.min_ns << std::setw(14) << result.max_ns
+            << std::endl;
+    }
+
+    std::array<bool, PerfCounters::EVENT_COUNT> is_collected{};
+    for (const BenchmarkResult& result : results) {
+        for (size_t event = 0; event < PerfCounters::EVENT_COUNT; ++event) {
+            is_collected[event] = is_collected[event] || result.perf_counters[event].has_value();
+        }
+    }
+    if (std::find(is_collected.begin(), is_collected.end(), true) != is_collected.end()) {
+        out << std::endl << std::left << std::setw(28) << "events per operation"sv << std::right;
+        for (size_t event = 0; event < PerfCounters::EVENT_COUNT; ++event) {
+            if (is_collected[event]) {
+                out << std::setw(18) << PerfCounters::GetEventName(static_cast<PerfCounters::Event>(event));
+            }
+        }
+        out << std::endl;
+        for (const BenchmarkResult& result : results) {
+            out << std::left << std::setw(28) << result.name << std::right;
+            for (size_t event = 0; event < PerfCounters::EVENT_COUNT; ++event) {
+                if (!is_collected[event]) {
+                    continue;
+                }
+                if (result.perf_counters[event]) {
+                    out << std::setw(18) << *result.perf_counters[event];
+                }
+                else {
+                    out << std::setw(18) << "-"sv;
+                }
+            }
+            out << std::endl;
+        }
+    }
+    out.unsetf(std::ios_base::floatfield);
+}
+
+void PrintBenchmarkComparisons(std::ostream& out, const std::vector<BenchmarkComparison>& comparisons) {
+    out << std::left << std::setw(28) << "benchmark"sv << std::right << std::setw(14) << "baseline, ns"sv
+        << std::setw(14) << "current, ns"sv << std::setw(10) << "change"sv << std::endl;
+    out << std::fixed << std::setprecision(1);
+    for (const BenchmarkComparison& comparison : comparisons) {
+        out << std::left << std::setw(28) << comparison.name << std::right << std::setw(14) << comparison.baseline_ns
+            << std::setw(14) << comparison.current_ns << std::setw(9) << comparison.change * 100.0 << '%'
+            << (comparison.is_regression ? "  REGRESSION"sv : ""sv) << std::endl;
+    }
+    out.unsetf(std::ios_base::floatfield);
+}
@@ -1,70 +1,92 @@
 #pragma once
 
-#include "search_server.h"
-#include "log_duration.h"
-
+#include <cstddef>
+#include <array>
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <random>
 
-std::string GenerateWord(std::mt19937& generator, int max_length) {
-    const int8_t length = std::uniform_int_distribution(1, max_length)(generator);
-    std::string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(static_cast<char>(std::uniform_int_distribution(97, 122)(generator)));
-    }
-    return word;
-}
-
-std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
-    std::vector<std::string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWord(generator, max_length));
-    }
-    sort(words.begin(), words.end());
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
-}
-std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int max_word_count) {
-    const int word_count = std::uniform_int_distribution(1, max_word_count)(generator);
-    std::string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
-        }
-        query += dictionary[std::uniform_int_distribution<int>(0, static_cast<int>(dictionary.size()) - 1)(generator)];
-    }
-    return query;
-}
-std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count) {
+#include "perf_counters.h"
+
+//   .      
+// :     r  1 / r^zipf_skew
+// (0 -  ).     -.
+struct CorpusOptions {
+    int vocabulary_size = 1'000;
+    int max_word_length = 10;
+    double zipf_skew = 1.0;
+    int document_count = 10'000;
+    int document_word_count = 70;
+    int query_count = 100;
+    int query_word_count = 7;
+    double minus_word_ratio = 0.1;
+    uint32_t seed = 5489;
+};
+
+struct Corpus {
+    std::vector<std::string> dictionary;
+    std::string stop_words;
+    std::vector<std::string> documents;
     std::vector<std::string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
-    }
-    return queries;
-}
-
-template <typename QueriesProcessor>
-void Test(std::string_view mark, QueriesProcessor processor, const SearchServer& search_server, const std::vector<std::string>& queries) {
-    LOG_DURATION(mark);
-    const auto documents_lists = processor(search_server, queries);
-}
-
-#define TEST(processor) Test(#processor, processor, search_server, queries)
-
-template <typename Func>
-void BenchMark(Func function) {
-    std::mt19937 generator;
-    const auto dictionary = GenerateDictionary(generator, 2'000, 25);
-    const auto documents = GenerateQueries(generator, dictionary, 20'000, 10);
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
-    }
-    const auto queries = GenerateQueries(generator, dictionary, 2'000, 7);
-    TEST(function);
-}
\ No newline at end of file
+};
+
+struct BenchmarkOptions {
+    int warmup_count = 1;
+    int repetition_count = 5;
+    bool collect_perf_counters = false;
+};
+
+//      
+struct BenchmarkResult {
+    std::string name;
+    size_t operation_count = 0;
+    int repetition_count = 0;
+    double min_ns = 0.0;
+    double median_ns = 0.0;
+    double mean_ns = 0.0;
+    double max_ns = 0.0;
+    //     ; ,    
+    std::array<std::optional<double>, PerfCounters::EVENT_COUNT> perf_counters;
+};
+
+struct BenchmarkComparison {
+    std::string name;
+    double baseline_ns = 0.0;
+    double current_ns = 0.0;
+    //   : 0.1 -  10%   
+    double change = 0.0;
+    bool is_regression = false;
+};
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+
+//   word_count ;     minus_word_ratio  -
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    std::discrete_distribution<int>& word_distribution, int word_count, double minus_word_ratio = 0.0);
+
+//             
+Corpus GenerateCorpus(const CorpusOptions& options);
+
+//    SearchServer  .   
+// ,  ,    
+std::vector<BenchmarkResult> RunBenchmarks(const Corpus& corpus, const BenchmarkOptions& options);
+
+void WriteBenchmarkJson(std::ostream& out, const CorpusOptions& corpus_options, const BenchmarkOptions& options,
+    const std::vector<BenchmarkResult>& results);
+
+//    JSON,  WriteBenchmarkJson
+std::vector<BenchmarkResult> ReadBenchmarkJson(std::istream& in);
+
+//  ;   threshold  
+std::vector<BenchmarkComparison> CompareBenchmarks(const std::vector<BenchmarkResult>& baseline,
+    const std::vector<BenchmarkResult>& results, double threshold);
+
+void PrintBenchmarkResults(std::ostream& out, const std::vector<BenchmarkResult>& results);
+
+void PrintBenchmarkComparisons(std::ostream& out, const std::vector<BenchmarkComparison>& comparisons);
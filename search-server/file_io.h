@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+//  data ,       
+bool WriteAll(int fd, std::string_view data);
+
+//    ,    path.    
+//       ,    
+bool SyncParentDirectory(const std::string& path);
@@ -0,0 +1,126 @@
+#include "index_file.h"
+
+#include "file_io.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr char INDEX_FILE_MAGIC[8] = { 'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0' };
+constexpr size_t SECTION_ALIGNMENT = 8;
+
+struct IndexFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+};
+
+struct SectionEntry {
+    uint64_t offset;
+    uint64_t size;
+};
+
+size_t AlignSectionOffset(size_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+}
+
+std::shared_ptr<const IndexFile> IndexFile::Open(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open index file "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(IndexFileHeader))) {
+        close(fd);
+        throw std::runtime_error("Invalid index file "s + path);
+    }
+    const size_t size = static_cast<size_t>(file_stat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Can't map index file "s + path);
+    }
+    return std::shared_ptr<const IndexFile>(new IndexFile(static_cast<const char*>(data), size));
+}
+
+IndexFile::IndexFile(const char* data, size_t size)
+    : data_(data)
+    , size_(size)
+{
+    IndexFileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    const size_t table_end = sizeof(IndexFileHeader) + sizeof(SectionEntry) * SECTION_COUNT;
+    if (std::memcmp(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) != 0
+        || header.version != VERSION || header.section_count != SECTION_COUNT || size_ < table_end) {
+        munmap(const_cast<char*>(data_), size_);
+        throw std::runtime_error("Unsupported index file format"s);
+    }
+    for (size_t i = 0; i < SECTION_COUNT; ++i) {
+        SectionEntry entry;
+        std::memcpy(&entry, data_ + sizeof(IndexFileHeader) + sizeof(SectionEntry) * i, sizeof(entry));
+        if (entry.offset % SECTION_ALIGNMENT != 0 || entry.offset < table_end
+            || entry.offset > size_ || entry.size > size_ - entry.offset) {
+            munmap(const_cast<char*>(data_), size_);
+            throw std::runtime_error("Corrupted index file section table"s);
+        }
+        sections_[i] = std::span<const char>(data_ + entry.offset, entry.size);
+    }
+}
+
+IndexFile::~IndexFile() {
+    munmap(const_cast<char*>(data_), size_);
+}
+
+void IndexFileWriter::Write(const std::string& path) const {
+    std::string header_bytes(sizeof(IndexFileHeader), '\0');
+    IndexFileHeader header{};
+    std::memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+    header.version = IndexFile::VERSION;
+    header.section_count = static_cast<uint32_t>(IndexFile::SECTION_COUNT);
+    std::memcpy(header_bytes.data(), &header, sizeof(header));
+
+    size_t offset = AlignSectionOffset(sizeof(IndexFileHeader) + sizeof(SectionEntry) * IndexFile::SECTION_COUNT);
+    for (const std::span<const char> section : sections_) {
+        const SectionEntry entry{ offset, section.size() };
+        header_bytes.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset = AlignSectionOffset(offset + section.size());
+    }
+
+    const std::string temp_path = path + ".tmp"s;
+    const int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Can't write index file "s + temp_path);
+    }
+    static constexpr char padding[SECTION_ALIGNMENT] = {};
+    bool is_written = WriteAll(fd, header_bytes);
+    size_t written = header_bytes.size();
+    for (const std::span<const char> section : sections_) {
+        is_written = is_written && WriteAll(fd, { padding, AlignSectionOffset(written) - written })
+            && WriteAll(fd, { section.data(), section.size() });
+        written = AlignSectionOffset(written) + section.size();
+    }
+    //      ,    
+    is_written = is_written && fsync(fd) == 0;
+    close(fd);
+    if (!is_written) {
+        throw std::runtime_error("Can't write index file "s + temp_path);
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Can't replace index file "s + path);
+    }
+    //   ,        
+    if (!SyncParentDirectory(path)) {
+        throw std::runtime_error("Can't sync directory of index file "s + path);
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+enum class IndexSection : uint32_t {
+    SETTINGS,
+    STOP_WORDS,
+    TERM_BYTES,
+    TERM_OFFSETS,
+    TERM_HASHES,
+    TERM_SLOTS,
+    POSTING_OFFSETS,
+    POSTING_ORDINALS,
+    POSTING_TERM_FREQS,
+    POSTING_MAX_TERM_FREQS,
+    DOCUMENT_IDS,
+    DOCUMENT_ORDINALS,
+    ORDINAL_DOCUMENT_IDS,
+    ORDINAL_RATINGS,
+    ORDINAL_STATUSES,
+    DOCUMENT_TEXT_OFFSETS,
+    DOCUMENT_TEXTS,
+    DOCUMENT_TERM_OFFSETS,
+    DOCUMENT_TERMS,
+    DOCUMENT_WORD_FREQS,
+    COUNT,
+};
+
+//  :   ,     ,
+//   8 .       ,
+//      .
+class IndexFile {
+public:
+    static constexpr uint32_t VERSION = 2;
+    static constexpr size_t SECTION_COUNT = static_cast<size_t>(IndexSection::COUNT);
+
+    static std::shared_ptr<const IndexFile> Open(const std::string& path);
+
+    IndexFile(const IndexFile&) = delete;
+    IndexFile& operator=(const IndexFile&) = delete;
+
+    ~IndexFile();
+
+    template <typename T>
+    std::span<const T> GetSection(IndexSection section) const;
+
+private:
+    IndexFile(const char* data, size_t size);
+
+    const char* data_;
+    size_t size_;
+    std::array<std::span<const char>, SECTION_COUNT> sections_;
+};
+
+class IndexFileWriter {
+public:
+    //       Write
+    template <typename T>
+    void SetSection(IndexSection section, std::span<const T> values);
+
+    template <typename T>
+    void SetSection(IndexSection section, const std::vector<T>& values);
+
+    //       ,   
+    //     
+    void Write(const std::string& path) const;
+
+private:
+    std::array<std::span<const char>, IndexFile::SECTION_COUNT> sections_;
+};
+
+template <typename T>
+std::span<const T> IndexFile::GetSection(IndexSection section) const {
+    const std::span<const char> bytes = sections_[static_cast<size_t>(section)];
+    if (bytes.size() % sizeof(T) != 0) {
+        throw std::runtime_error("Invalid index file section size");
+    }
+    return std::span<const T>(reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T));
+}
+
+template <typename T>
+void IndexFileWriter::SetSection(IndexSection section, std::span<const T> values) {
+    sections_[static_cast<size_t>(section)] = std::span<const char>(
+        reinterpret_cast<const char*>(values.data()), values.size_bytes());
+}
+
+template <typename T>
+void IndexFileWriter::SetSection(IndexSection section, const std::vector<T>& values) {
+    SetSection(section, std::span<const T>(values));
+}
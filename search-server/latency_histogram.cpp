@@ -0,0 +1,79 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+void LatencyHistogram::Add(uint64_t value) {
+    buckets_[GetBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        if (const uint64_t count = other.buckets_[bucket].load(std::memory_order_relaxed)) {
+            buckets_[bucket].fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.count_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Clear() {
+    for (std::atomic<uint64_t>& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetCount() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetSum() const {
+    return sum_.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetValueAtQuantile(double quantile) const {
+    //      ,   
+    //   
+    uint64_t count = 0;
+    for (const std::atomic<uint64_t>& bucket : buckets_) {
+        count += bucket.load(std::memory_order_relaxed);
+    }
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * count)));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += buckets_[bucket].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return GetBucketUpperBound(bucket);
+        }
+    }
+    return GetBucketUpperBound(BUCKET_COUNT - 1);
+}
+
+size_t LatencyHistogram::GetBucket(uint64_t value) {
+    if (value < SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value);
+    }
+    const int exponent = std::bit_width(value) - 1;
+    if (exponent >= MAX_VALUE_BITS) {
+        return BUCKET_COUNT - 1;
+    }
+    const int shift = exponent - SUB_BUCKET_BITS;
+    return static_cast<size_t>(shift + 1) * SUB_BUCKET_COUNT + static_cast<size_t>((value >> shift) - SUB_BUCKET_COUNT);
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t bucket) {
+    if (bucket < SUB_BUCKET_COUNT) {
+        return bucket;
+    }
+    const int shift = static_cast<int>(bucket / SUB_BUCKET_COUNT) - 1;
+    const uint64_t lower_bound = (SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT) << shift;
+    return lower_bound + (uint64_t{ 1 } << shift) - 1;
+}
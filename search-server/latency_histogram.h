@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+//    .  -:
+//      SUB_BUCKET_COUNT  ,  
+//      1/SUB_BUCKET_COUNT 
+//   .       .
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKET_COUNT = size_t{ 1 } << SUB_BUCKET_BITS;
+    //   2^MAX_VALUE_BITS  ( )    
+    static constexpr int MAX_VALUE_BITS = 36;
+    static constexpr size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    void Add(uint64_t value);
+
+    void Merge(const LatencyHistogram& other);
+
+    void Clear();
+
+    uint64_t GetCount() const;
+
+    uint64_t GetSum() const;
+
+    //   ,     quantile 
+    uint64_t GetValueAtQuantile(double quantile) const;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_ = 0;
+    std::atomic<uint64_t> sum_ = 0;
+
+    static size_t GetBucket(uint64_t value);
+
+    static uint64_t GetBucketUpperBound(size_t bucket);
+};
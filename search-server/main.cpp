@@ -1,73 +1,130 @@
-#include "search_server.h"
-#include "log_duration.h"
-#include "process_queries.h"
-#include <execution>
+#include "benchmark.h"
+#include "unit_tests.h"
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
-#include <random>
 #include <string>
-#include <vector>
+#include <string_view>
 using namespace std;
-string GenerateWord(mt19937& generator, int max_length) {
-    const int length = uniform_int_distribution<>(1, max_length)(generator);
-    string word;
-    word.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        word.push_back(uniform_int_distribution<>('a', 'z')(generator));
-    }
-    return word;
-}
-vector<string> GenerateDictionary(mt19937& generator, int word_count, int max_length) {
-    vector<string> words;
-    words.reserve(word_count);
-    for (int i = 0; i < word_count; ++i) {
-        words.push_back(GenerateWord(generator, max_length));
-    }
-    words.erase(unique(words.begin(), words.end()), words.end());
-    return words;
+
+void PrintUsage(ostream& out) {
+    out << "Usage: search-server [options]\n"
+        "Corpus:\n"
+        "  --vocabulary N        dictionary size (1000)\n"
+        "  --word-length N       max word length (10)\n"
+        "  --zipf S              Zipf skew of word frequencies, 0 - uniform (1.0)\n"
+        "  --documents N         document count (10000)\n"
+        "  --document-words N    words per document (70)\n"
+        "  --queries N           query count (100)\n"
+        "  --query-words N       words per query (7)\n"
+        "  --minus-ratio R       share of minus words in queries (0.1)\n"
+        "  --seed N              random seed (5489)\n"
+        "Run:\n"
+        "  --warmup N            unmeasured repetitions (1)\n"
+        "  --repetitions N       measured repetitions (5)\n"
+        "  --json PATH           write results as JSON\n"
+        "  --baseline PATH       compare with JSON of a previous run\n"
+        "  --threshold R         median slowdown reported as regression (0.1)\n"
+        "  --perf-counters       collect hardware counters per operation (Linux)\n"
+        "  --test                run unit tests instead of benchmarks\n"s;
 }
-string GenerateQuery(mt19937& generator, const vector<string>& dictionary, int word_count, double minus_prob = 0) {
-    string query;
-    for (int i = 0; i < word_count; ++i) {
-        if (!query.empty()) {
-            query.push_back(' ');
+
+int main(int argc, char* argv[]) {
+    CorpusOptions corpus_options;
+    BenchmarkOptions options;
+    string json_path;
+    string baseline_path;
+    double threshold = 0.1;
+    for (int i = 1; i < argc; ++i) {
+        const string_view name = argv[i];
+        if (name == "--help"sv) {
+            PrintUsage(cout);
+            return 0;
+        }
+        if (name == "--test"sv) {
+            TestIndexStorage();
+            TestSearchComponents();
+            return 0;
+        }
+        if (name == "--perf-counters"sv) {
+            options.collect_perf_counters = true;
+            continue;
+        }
+        if (i + 1 == argc) {
+            PrintUsage(cerr);
+            return 2;
+        }
+        const string value = argv[++i];
+        if (name == "--vocabulary"sv) {
+            corpus_options.vocabulary_size = stoi(value);
+        }
+        else if (name == "--word-length"sv) {
+            corpus_options.max_word_length = stoi(value);
+        }
+        else if (name == "--zipf"sv) {
+            corpus_options.zipf_skew = stod(value);
+        }
+        else if (name == "--documents"sv) {
+            corpus_options.document_count = stoi(value);
+        }
+        else if (name == "--document-words"sv) {
+            corpus_options.document_word_count = stoi(value);
+        }
+        else if (name == "--queries"sv) {
+            corpus_options.query_count = stoi(value);
+        }
+        else if (name == "--query-words"sv) {
+            corpus_options.query_word_count = stoi(value);
+        }
+        else if (name == "--minus-ratio"sv) {
+            corpus_options.minus_word_ratio = stod(value);
         }
-        if (uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
-            query.push_back('-');
+        else if (name == "--seed"sv) {
+            corpus_options.seed = static_cast<uint32_t>(stoul(value));
+        }
+        else if (name == "--warmup"sv) {
+            options.warmup_count = stoi(value);
+        }
+        else if (name == "--repetitions"sv) {
+            options.repetition_count = stoi(value);
+        }
+        else if (name == "--json"sv) {
+            json_path = value;
+        }
+        else if (name == "--baseline"sv) {
+            baseline_path = value;
+        }
+        else if (name == "--threshold"sv) {
+            threshold = stod(value);
+        }
+        else {
+            PrintUsage(cerr);
+            return 2;
         }
-        query += dictionary[uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
     }
-    return query;
-}
-vector<string> GenerateQueries(mt19937& generator, const vector<string>& dictionary, int query_count, int max_word_count) {
-    vector<string> queries;
-    queries.reserve(query_count);
-    for (int i = 0; i < query_count; ++i) {
-        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+
+    const Corpus corpus = GenerateCorpus(corpus_options);
+    const vector<BenchmarkResult> results = RunBenchmarks(corpus, options);
+    PrintBenchmarkResults(cout, results);
+    if (!json_path.empty()) {
+        ofstream out(json_path);
+        WriteBenchmarkJson(out, corpus_options, options, results);
     }
-    return queries;
-}
-template <typename ExecutionPolicy>
-void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
-    LOG_DURATION(mark);
-    double total_relevance = 0;
-    for (const string_view query : queries) {
-        for (const auto& document : search_server.FindTopDocuments(policy, query)) {
-            total_relevance += document.relevance;
-        }
+    if (baseline_path.empty()) {
+        return 0;
     }
-    cout << total_relevance << endl;
-}
-#define TEST(policy) Test(#policy, search_server, queries, execution::policy)
-int main() {
-    mt19937 generator;
-    const auto dictionary = GenerateDictionary(generator, 1000, 10);
-    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
-    SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    ifstream in(baseline_path);
+    if (!in) {
+        cerr << "Cannot open baseline "s << baseline_path << endl;
+        return 2;
+    }
+    const vector<BenchmarkComparison> comparisons = CompareBenchmarks(ReadBenchmarkJson(in), results, threshold);
+    cout << endl;
+    PrintBenchmarkComparisons(cout, comparisons);
+    for (const BenchmarkComparison& comparison : comparisons) {
+        if (comparison.is_regression) {
+            return 1;
+        }
     }
-    const auto queries = GenerateQueries(generator, dictionary, 100, 70);
-    TEST(seq);
-    TEST(par);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+//  ,     ,    
+//   (  ).   .
+template <typename T>
+class MappedColumn {
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    MappedColumn() = default;
+
+    explicit MappedColumn(std::vector<T> values)
+        : values_(std::move(values))
+    {
+    }
+
+    explicit MappedColumn(std::span<const T> mapped_values)
+        : mapped_values_(mapped_values)
+        , is_mapped_(true)
+    {
+    }
+
+    const T* begin() const {
+        return data();
+    }
+
+    const T* end() const {
+        return data() + size();
+    }
+
+    const T* data() const {
+        return is_mapped_ ? mapped_values_.data() : values_.data();
+    }
+
+    size_t size() const {
+        return is_mapped_ ? mapped_values_.size() : values_.size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    const T& operator[](size_t index) const {
+        return data()[index];
+    }
+
+    std::vector<T>& GetMutable() {
+        if (is_mapped_) {
+            values_.assign(mapped_values_.begin(), mapped_values_.end());
+            mapped_values_ = {};
+            is_mapped_ = false;
+        }
+        return values_;
+    }
+
+    void push_back(const T& value) {
+        GetMutable().push_back(value);
+    }
+
+private:
+    std::vector<T> values_;
+    std::span<const T> mapped_values_;
+    bool is_mapped_ = false;
+};
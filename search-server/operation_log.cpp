@@ -0,0 +1,256 @@
+#include "operation_log.h"
+
+#include "file_io.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+const std::array<uint32_t, 256> CRC32_TABLE = [] {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < table.size(); ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}();
+
+uint32_t ComputeCrc32(std::string_view data) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (const char c : data) {
+        crc = CRC32_TABLE[(crc ^ static_cast<uint8_t>(c)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template <typename T>
+void AppendValue(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool ReadValue(std::string_view& in, T& value) {
+    if (in.size() < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in.data(), sizeof(value));
+    in.remove_prefix(sizeof(value));
+    return true;
+}
+
+bool ParseRecord(std::string_view payload, OperationLog::Record& record) {
+    uint8_t type = 0;
+    if (!ReadValue(payload, record.sequence) || !ReadValue(payload, type) || !ReadValue(payload, record.document_id)) {
+        return false;
+    }
+    record.type = static_cast<OperationLog::RecordType>(type);
+    if (record.type == OperationLog::RecordType::REMOVE_DOCUMENT) {
+        return payload.empty();
+    }
+    if (record.type != OperationLog::RecordType::ADD_DOCUMENT) {
+        return false;
+    }
+    int32_t status = 0;
+    uint32_t rating_count = 0;
+    if (!ReadValue(payload, status) || !ReadValue(payload, rating_count)
+        || payload.size() < static_cast<size_t>(rating_count) * sizeof(int)) {
+        return false;
+    }
+    record.status = static_cast<DocumentStatus>(status);
+    record.ratings.resize(rating_count);
+    for (int& rating : record.ratings) {
+        ReadValue(payload, rating);
+    }
+    uint32_t text_size = 0;
+    if (!ReadValue(payload, text_size) || payload.size() != text_size) {
+        return false;
+    }
+    record.text = std::string(payload);
+    return true;
+}
+
+}
+
+OperationLog::OperationLog(const std::string& path, uint64_t last_sequence)
+    : path_(path)
+    , last_sequence_(last_sequence)
+    , durable_sequence_(last_sequence)
+{
+    size_t valid_size = 0;
+    for (const Record& record : ReadRecords(path_, &valid_size)) {
+        last_sequence_ = std::max(last_sequence_, record.sequence);
+    }
+    durable_sequence_ = last_sequence_;
+    OpenFile();
+    if (ftruncate(fd_, static_cast<off_t>(valid_size)) != 0 || lseek(fd_, 0, SEEK_END) < 0) {
+        close(fd_);
+        throw std::runtime_error("Can't truncate operation log "s + path_);
+    }
+    //            
+    if (!SyncParentDirectory(path_)) {
+        close(fd_);
+        throw std::runtime_error("Can't sync directory of operation log "s + path_);
+    }
+}
+
+OperationLog::~OperationLog() {
+    try {
+        std::unique_lock lock(mutex_);
+        durable_cv_.wait(lock, [this] { return !is_flushing_; });
+        FlushPendingLocked();
+    }
+    catch (...) {
+    }
+    close(fd_);
+}
+
+uint64_t OperationLog::AppendAddDocument(int document_id, const std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    std::string payload_tail;
+    AppendValue(payload_tail, static_cast<int32_t>(status));
+    AppendValue(payload_tail, static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        AppendValue(payload_tail, rating);
+    }
+    AppendValue(payload_tail, static_cast<uint32_t>(document.size()));
+    payload_tail.append(document);
+    return Append(payload_tail, RecordType::ADD_DOCUMENT, document_id);
+}
+
+uint64_t OperationLog::AppendRemoveDocument(int document_id) {
+    return Append({}, RecordType::REMOVE_DOCUMENT, document_id);
+}
+
+uint64_t OperationLog::Append(const std::string& payload_tail, RecordType type, int document_id) {
+    std::lock_guard guard(mutex_);
+    const uint64_t sequence = ++last_sequence_;
+    std::string payload;
+    AppendValue(payload, sequence);
+    AppendValue(payload, static_cast<uint8_t>(type));
+    AppendValue(payload, document_id);
+    payload += payload_tail;
+    AppendValue(pending_, static_cast<uint32_t>(payload.size()));
+    AppendValue(pending_, ComputeCrc32(payload));
+    pending_ += payload;
+    return sequence;
+}
+
+void OperationLog::WaitDurable(uint64_t sequence) {
+    std::unique_lock lock(mutex_);
+    while (durable_sequence_ < sequence) {
+        if (is_flushing_) {
+            durable_cv_.wait(lock);
+            continue;
+        }
+        is_flushing_ = true;
+        const std::string batch = std::move(pending_);
+        pending_.clear();
+        const uint64_t batch_sequence = last_sequence_;
+        lock.unlock();
+        const off_t size_before = lseek(fd_, 0, SEEK_END);
+        const bool is_written = WriteAll(fd_, batch) && fdatasync(fd_) == 0;
+        lock.lock();
+        is_flushing_ = false;
+        if (is_written) {
+            durable_sequence_ = batch_sequence;
+        }
+        else {
+            //     ,     
+            [[maybe_unused]] const int result = ftruncate(fd_, size_before);
+            pending_.insert(0, batch);
+        }
+        durable_cv_.notify_all();
+        if (!is_written) {
+            throw std::runtime_error("Can't sync operation log "s + path_);
+        }
+    }
+}
+
+void OperationLog::Rotate() {
+    std::unique_lock lock(mutex_);
+    durable_cv_.wait(lock, [this] { return !is_flushing_; });
+    FlushPendingLocked();
+    const std::string rotated_path = GetRotatedPath(path_);
+    if (access(rotated_path.c_str(), F_OK) == 0) {
+        return;
+    }
+    close(fd_);
+    if (std::rename(path_.c_str(), rotated_path.c_str()) != 0) {
+        OpenFile();
+        throw std::runtime_error("Can't rotate operation log "s + path_);
+    }
+    OpenFile();
+    //         ,  
+    //    
+    if (!SyncParentDirectory(path_)) {
+        throw std::runtime_error("Can't sync directory of operation log "s + path_);
+    }
+}
+
+void OperationLog::RemoveRotated() {
+    std::remove(GetRotatedPath(path_).c_str());
+}
+
+std::string OperationLog::GetRotatedPath(const std::string& path) {
+    return path + ".1"s;
+}
+
+std::vector<OperationLog::Record> OperationLog::ReadRecords(const std::string& path, size_t* valid_size) {
+    std::ifstream in(path, std::ios::binary);
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<Record> records;
+    size_t pos = 0;
+    while (data.size() - pos >= RECORD_HEADER_SIZE) {
+        uint32_t payload_size = 0;
+        uint32_t crc = 0;
+        std::memcpy(&payload_size, data.data() + pos, sizeof(payload_size));
+        std::memcpy(&crc, data.data() + pos + sizeof(payload_size), sizeof(crc));
+        if (data.size() - pos - RECORD_HEADER_SIZE < payload_size) {
+            break;
+        }
+        const std::string_view payload(data.data() + pos + RECORD_HEADER_SIZE, payload_size);
+        Record record;
+        if (ComputeCrc32(payload) != crc || !ParseRecord(payload, record)) {
+            break;
+        }
+        records.push_back(std::move(record));
+        pos += RECORD_HEADER_SIZE + payload_size;
+    }
+    if (valid_size) {
+        *valid_size = pos;
+    }
+    return records;
+}
+
+void OperationLog::OpenFile() {
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Can't open operation log "s + path_);
+    }
+}
+
+void OperationLog::FlushPendingLocked() {
+    if (pending_.empty()) {
+        return;
+    }
+    if (!WriteAll(fd_, pending_) || fdatasync(fd_) != 0) {
+        throw std::runtime_error("Can't sync operation log "s + path_);
+    }
+    pending_.clear();
+    durable_sequence_ = last_sequence_;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+//   AddDocument/RemoveDocument.     
+//    :      
+//      ,    .
+class OperationLog {
+public:
+    enum class RecordType : uint8_t {
+        ADD_DOCUMENT = 1,
+        REMOVE_DOCUMENT = 2,
+    };
+
+    struct Record {
+        uint64_t sequence = 0;
+        RecordType type = RecordType::ADD_DOCUMENT;
+        int document_id = 0;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        std::vector<int> ratings;
+        std::string text;
+    };
+
+    OperationLog(const std::string& path, uint64_t last_sequence);
+
+    OperationLog(const OperationLog&) = delete;
+    OperationLog& operator=(const OperationLog&) = delete;
+
+    ~OperationLog();
+
+    uint64_t AppendAddDocument(int document_id, const std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings);
+
+    uint64_t AppendRemoveDocument(int document_id);
+
+    void WaitDurable(uint64_t sequence);
+
+    //     GetRotatedPath(path),   
+    //     .      
+    //  ,   :     
+    void Rotate();
+
+    void RemoveRotated();
+
+    static std::string GetRotatedPath(const std::string& path);
+
+    //     : ,   , 
+    static std::vector<Record> ReadRecords(const std::string& path, size_t* valid_size = nullptr);
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    std::mutex mutex_;
+    std::condition_variable durable_cv_;
+    std::string pending_;
+    uint64_t last_sequence_;
+    uint64_t durable_sequence_;
+    bool is_flushing_ = false;
+
+    uint64_t Append(const std::string& payload_tail, RecordType type, int document_id);
+
+    void OpenFile();
+
+    void FlushPendingLocked();
+};
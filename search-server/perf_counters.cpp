@@ -0,0 +1,130 @@
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std::literals;
+
+namespace {
+
+#ifdef __linux__
+int OpenEvent(uint32_t type, uint64_t config) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    //         
+    attr.exclude_kernel = type == PERF_TYPE_SOFTWARE ? 0 : 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    const long descriptor = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    return static_cast<int>(descriptor);
+}
+
+uint64_t MakeCacheConfig(uint64_t cache, uint64_t operation, uint64_t result) {
+    return cache | (operation << 8) | (result << 16);
+}
+#endif
+
+}  // namespace
+
+PerfCounters::PerfCounters() {
+    descriptors_.fill(-1);
+#ifdef __linux__
+    descriptors_[static_cast<size_t>(Event::CYCLES)] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    descriptors_[static_cast<size_t>(Event::INSTRUCTIONS)] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    descriptors_[static_cast<size_t>(Event::L1D_MISSES)] = OpenEvent(PERF_TYPE_HW_CACHE,
+        MakeCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+    descriptors_[static_cast<size_t>(Event::LLC_MISSES)] = OpenEvent(PERF_TYPE_HW_CACHE,
+        MakeCacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+    descriptors_[static_cast<size_t>(Event::BRANCH_MISSES)] = OpenEvent(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    descriptors_[static_cast<size_t>(Event::CONTEXT_SWITCHES)] = OpenEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (const int descriptor : descriptors_) {
+        if (descriptor >= 0) {
+            close(descriptor);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::IsAvailable() const {
+    for (const int descriptor : descriptors_) {
+        if (descriptor >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PerfCounters::IsAvailable(Event event) const {
+    return descriptors_[static_cast<size_t>(event)] >= 0;
+}
+
+void PerfCounters::Start() {
+#ifdef __linux__
+    for (const int descriptor : descriptors_) {
+        if (descriptor >= 0) {
+            ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+            ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfCounters::Values PerfCounters::Stop() {
+    Values values;
+#ifdef __linux__
+    for (const int descriptor : descriptors_) {
+        if (descriptor >= 0) {
+            ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (size_t event = 0; event < EVENT_COUNT; ++event) {
+        if (descriptors_[event] < 0) {
+            continue;
+        }
+        struct {
+            uint64_t value;
+            uint64_t time_enabled;
+            uint64_t time_running;
+        } reading{};
+        if (read(descriptors_[event], &reading, sizeof(reading)) != static_cast<ssize_t>(sizeof(reading))
+            || reading.time_running == 0) {
+            continue;
+        }
+        values[event] = reading.time_running < reading.time_enabled
+            ? static_cast<uint64_t>(static_cast<double>(reading.value) * reading.time_enabled / reading.time_running)
+            : reading.value;
+    }
+#endif
+    return values;
+}
+
+std::string_view PerfCounters::GetEventName(Event event) {
+    switch (event) {
+    case Event::CYCLES:
+        return "cycles"sv;
+    case Event::INSTRUCTIONS:
+        return "instructions"sv;
+    case Event::L1D_MISSES:
+        return "l1d_misses"sv;
+    case Event::LLC_MISSES:
+        return "llc_misses"sv;
+    case Event::BRANCH_MISSES:
+        return "branch_misses"sv;
+    case Event::CONTEXT_SWITCHES:
+        return "context_switches"sv;
+    }
+    return "unknown"sv;
+}
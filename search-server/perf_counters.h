@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+//      Linux (perf_event_open).
+//      ,    Start;
+//        .
+// ,        ( PMU 
+//  ,  perf_event_paranoid,  Linux),  .
+class PerfCounters {
+public:
+    enum class Event {
+        CYCLES = 0,
+        INSTRUCTIONS = 1,
+        L1D_MISSES = 2,
+        LLC_MISSES = 3,
+        BRANCH_MISSES = 4,
+        CONTEXT_SWITCHES = 5,
+    };
+    static constexpr size_t EVENT_COUNT = 6;
+
+    //   -  
+    using Values = std::array<std::optional<uint64_t>, EVENT_COUNT>;
+
+    PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters();
+
+    bool IsAvailable() const;
+
+    bool IsAvailable(Event event) const;
+
+    //    
+    void Start();
+
+    //  .       ,
+    //      
+    Values Stop();
+
+    static std::string_view GetEventName(Event event);
+
+private:
+    std::array<int, EVENT_COUNT> descriptors_;
+};
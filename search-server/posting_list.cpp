@@ -0,0 +1,350 @@
+#include "posting_list.h"
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POSTING_LIST_AVX2
+#endif
+
+namespace {
+
+void PackBits(std::span<const uint32_t> values, unsigned bits, std::vector<uint8_t>& data) {
+    uint64_t buffer = 0;
+    unsigned buffered = 0;
+    for (const uint32_t value : values) {
+        buffer |= uint64_t{ value } << buffered;
+        buffered += bits;
+        for (; buffered >= 8; buffered -= 8) {
+            data.push_back(static_cast<uint8_t>(buffer));
+            buffer >>= 8;
+        }
+    }
+    if (buffered > 0) {
+        data.push_back(static_cast<uint8_t>(buffer));
+    }
+}
+
+unsigned GetBitWidth(std::span<const uint32_t> values) {
+    uint32_t all_bits = 0;
+    for (const uint32_t value : values) {
+        all_bits |= value;
+    }
+    return static_cast<unsigned>(std::bit_width(all_bits));
+}
+
+size_t GetPackedSize(size_t count, unsigned bits) {
+    return (count * bits + 7) / 8;
+}
+
+uint64_t LoadWord(const uint8_t* data) {
+    //        ,
+    //       
+    uint64_t word = 0;
+    for (size_t i = 0; i < sizeof(word); ++i) {
+        word |= uint64_t{ data[i] } << (i * 8);
+    }
+    return word;
+}
+
+void UnpackBitsScalar(const uint8_t* data, size_t first, size_t count, unsigned bits, uint32_t* values) {
+    if (bits == 0) {
+        std::fill(values + first, values + count, 0);
+        return;
+    }
+    const uint64_t mask = (uint64_t{ 1 } << bits) - 1;
+    for (size_t i = first; i < count; ++i) {
+        const size_t bit = i * bits;
+        values[i] = static_cast<uint32_t>((LoadWord(data + bit / 8) >> (bit % 8)) & mask);
+    }
+}
+
+void DecodeBlockScalar(const PostingBlockHeader& header, const uint8_t* data, const double* term_freq_table,
+    PostingList::BlockBuffer& buffer) {
+    const uint8_t* block_data = data + header.offset;
+    uint32_t* ordinals = buffer.ordinals.data();
+    UnpackBitsScalar(block_data, 0, header.size, header.ordinal_bits, ordinals);
+    DocumentOrdinal ordinal = header.first_ordinal - 1;
+    for (size_t i = 0; i < header.size; ++i) {
+        ordinal += ordinals[i] + 1;
+        ordinals[i] = ordinal;
+    }
+
+    uint32_t codes[PostingList::BLOCK_SIZE];
+    UnpackBitsScalar(block_data + GetPackedSize(header.size, header.ordinal_bits), 0, header.size, header.term_freq_bits, codes);
+    for (size_t i = 0; i < header.size; ++i) {
+        buffer.term_freqs[i] = term_freq_table[codes[i]];
+    }
+}
+
+#ifdef POSTING_LIST_AVX2
+
+//    :     32- ,
+//     ,     25 
+constexpr unsigned MAX_AVX2_BIT_WIDTH = 25;
+
+__attribute__((target("avx2")))
+void UnpackBitsAvx2(const uint8_t* data, size_t count, unsigned bits, uint32_t* values) {
+    if (bits == 0 || bits > MAX_AVX2_BIT_WIDTH) {
+        UnpackBitsScalar(data, 0, count, bits, values);
+        return;
+    }
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i widths = _mm256_set1_epi32(static_cast<int>(bits));
+    const __m256i mask = _mm256_set1_epi32(static_cast<int>((uint32_t{ 1 } << bits) - 1));
+    const __m256i byte_mask = _mm256_set1_epi32(7);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i positions = _mm256_mullo_epi32(_mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(i))), widths);
+        const __m256i words = _mm256_i32gather_epi32(reinterpret_cast<const int*>(data), _mm256_srli_epi32(positions, 3), 1);
+        const __m256i shifted = _mm256_srlv_epi32(words, _mm256_and_si256(positions, byte_mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), _mm256_and_si256(shifted, mask));
+    }
+    UnpackBitsScalar(data, i, count, bits, values);
+}
+
+__attribute__((target("avx2")))
+void DecodeBlockAvx2(const PostingBlockHeader& header, const uint8_t* data, const double* term_freq_table,
+    PostingList::BlockBuffer& buffer) {
+    const uint8_t* block_data = data + header.offset;
+    uint32_t* ordinals = buffer.ordinals.data();
+    UnpackBitsAvx2(block_data, header.size, header.ordinal_bits, ordinals);
+
+    //   ( + 1)  :   128-
+    // ,       
+    const __m256i ones = _mm256_set1_epi32(1);
+    __m256i running = _mm256_set1_epi32(static_cast<int>(header.first_ordinal - 1));
+    size_t i = 0;
+    for (; i + 8 <= header.size; i += 8) {
+        __m256i sums = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ordinals + i)), ones);
+        sums = _mm256_add_epi32(sums, _mm256_slli_si256(sums, 4));
+        sums = _mm256_add_epi32(sums, _mm256_slli_si256(sums, 8));
+        const __m256i low_total = _mm256_shuffle_epi32(sums, 0xFF);
+        sums = _mm256_add_epi32(sums, _mm256_permute2x128_si256(low_total, low_total, 0x08));
+        sums = _mm256_add_epi32(sums, running);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ordinals + i), sums);
+        running = _mm256_permutevar8x32_epi32(sums, _mm256_set1_epi32(7));
+    }
+    DocumentOrdinal ordinal = static_cast<DocumentOrdinal>(_mm256_extract_epi32(running, 0));
+    for (; i < header.size; ++i) {
+        ordinal += ordinals[i] + 1;
+        ordinals[i] = ordinal;
+    }
+
+    alignas(32) uint32_t codes[PostingList::BLOCK_SIZE];
+    UnpackBitsAvx2(block_data + GetPackedSize(header.size, header.ordinal_bits), header.size, header.term_freq_bits, codes);
+    const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    i = 0;
+    for (; i + 4 <= header.size; i += 4) {
+        const __m128i indices = _mm_load_si128(reinterpret_cast<const __m128i*>(codes + i));
+        _mm256_store_pd(buffer.term_freqs.data() + i,
+            _mm256_mask_i32gather_pd(_mm256_setzero_pd(), term_freq_table, indices, all_lanes, 8));
+    }
+    for (; i < header.size; ++i) {
+        buffer.term_freqs[i] = term_freq_table[codes[i]];
+    }
+}
+
+#endif
+
+using DecodeBlockFunction = void (*)(const PostingBlockHeader&, const uint8_t*, const double*, PostingList::BlockBuffer&);
+
+DecodeBlockFunction SelectDecodeBlock() {
+#ifdef POSTING_LIST_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return DecodeBlockAvx2;
+    }
+#endif
+    return DecodeBlockScalar;
+}
+
+std::atomic<DecodeBlockFunction> decode_block = SelectDecodeBlock();
+
+}  // namespace
+
+PostingList::PostingList(std::span<const DocumentOrdinal> ordinals, std::span<const double> term_freqs,
+    double max_term_freq)
+    : mapped_ordinals_(ordinals)
+    , mapped_term_freqs_(term_freqs)
+    , max_term_freq_(max_term_freq)
+{
+}
+
+PostingList::PostingList(std::span<const PostingBlockHeader> blocks, const uint8_t* block_data,
+    const double* term_freq_table, size_t size, double max_term_freq)
+    : blocks_(blocks)
+    , block_data_(block_data)
+    , term_freq_table_(term_freq_table)
+    , compressed_size_(size)
+    , max_term_freq_(max_term_freq)
+{
+}
+
+void PostingList::EncodeBlocks(std::span<const DocumentOrdinal> ordinals, std::span<const uint32_t> term_freq_codes,
+    std::vector<uint8_t>& block_data, std::vector<PostingBlockHeader>& blocks) {
+    uint32_t gaps[BLOCK_SIZE];
+    for (size_t first = 0; first < ordinals.size(); first += BLOCK_SIZE) {
+        const size_t size = std::min(BLOCK_SIZE, ordinals.size() - first);
+        gaps[0] = 0;
+        for (size_t i = 1; i < size; ++i) {
+            gaps[i] = ordinals[first + i] - ordinals[first + i - 1] - 1;
+        }
+        const std::span<const uint32_t> block_gaps(gaps, size);
+        const std::span<const uint32_t> block_codes = term_freq_codes.subspan(first, size);
+
+        PostingBlockHeader header;
+        header.offset = block_data.size();
+        header.first_ordinal = ordinals[first];
+        header.last_ordinal = ordinals[first + size - 1];
+        header.size = static_cast<uint16_t>(size);
+        header.ordinal_bits = static_cast<uint8_t>(GetBitWidth(block_gaps));
+        header.term_freq_bits = static_cast<uint8_t>(GetBitWidth(block_codes));
+        PackBits(block_gaps, header.ordinal_bits, block_data);
+        PackBits(block_codes, header.term_freq_bits, block_data);
+        blocks.push_back(header);
+    }
+}
+
+bool PostingList::IsVectorDecodingSupported() {
+    return SelectDecodeBlock() != DecodeBlockScalar;
+}
+
+void PostingList::SetVectorDecoding(bool is_enabled) {
+    decode_block.store(is_enabled ? SelectDecodeBlock() : DecodeBlockScalar, std::memory_order_relaxed);
+}
+
+void PostingList::Add(DocumentOrdinal ordinal, double term_freq) {
+    Materialize();
+    if (ordinals_.empty() || ordinals_.back() < ordinal) {
+        ordinals_.push_back(ordinal);
+        term_freqs_.push_back(term_freq);
+        max_term_freq_ = std::max(max_term_freq_, term_freq);
+        return;
+    }
+    const auto it = std::lower_bound(ordinals_.begin(), ordinals_.end(), ordinal);
+    const auto pos = it - ordinals_.begin();
+    if (*it == ordinal) {
+        term_freqs_[pos] += term_freq;
+        max_term_freq_ = std::max(max_term_freq_, term_freqs_[pos]);
+    }
+    else {
+        ordinals_.insert(it, ordinal);
+        term_freqs_.insert(term_freqs_.begin() + pos, term_freq);
+        max_term_freq_ = std::max(max_term_freq_, term_freq);
+    }
+}
+
+void PostingList::Remove(DocumentOrdinal ordinal) {
+    Materialize();
+    const auto it = std::lower_bound(ordinals_.begin(), ordinals_.end(), ordinal);
+    if (it == ordinals_.end() || *it != ordinal) {
+        return;
+    }
+    const auto term_freq_it = term_freqs_.begin() + (it - ordinals_.begin());
+    const bool is_max = *term_freq_it >= max_term_freq_;
+    term_freqs_.erase(term_freq_it);
+    ordinals_.erase(it);
+    if (is_max) {
+        max_term_freq_ = term_freqs_.empty() ? 0.0 : *std::max_element(term_freqs_.begin(), term_freqs_.end());
+    }
+}
+
+bool PostingList::Contains(DocumentOrdinal ordinal) const {
+    if (!IsCompressed()) {
+        const std::span<const DocumentOrdinal> ordinals = GetOrdinals();
+        return std::binary_search(ordinals.begin(), ordinals.end(), ordinal);
+    }
+    const size_t block = FindBlock(ordinal);
+    if (block == blocks_.size() || blocks_[block].first_ordinal > ordinal) {
+        return false;
+    }
+    BlockBuffer buffer;
+    const Block postings = GetBlock(block, buffer);
+    return std::binary_search(postings.ordinals.begin(), postings.ordinals.end(), ordinal);
+}
+
+size_t PostingList::size() const {
+    return IsCompressed() ? compressed_size_ : GetOrdinals().size();
+}
+
+bool PostingList::empty() const {
+    return size() == 0;
+}
+
+size_t PostingList::GetBlockCount() const {
+    return IsCompressed() ? blocks_.size() : (GetOrdinals().size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
+DocumentOrdinal PostingList::GetBlockLastOrdinal(size_t block) const {
+    if (IsCompressed()) {
+        return blocks_[block].last_ordinal;
+    }
+    const std::span<const DocumentOrdinal> ordinals = GetOrdinals();
+    return ordinals[std::min(ordinals.size(), (block + 1) * BLOCK_SIZE) - 1];
+}
+
+size_t PostingList::FindBlock(DocumentOrdinal ordinal, size_t first_block) const {
+    if (IsCompressed()) {
+        return std::partition_point(blocks_.begin() + first_block, blocks_.end(), [ordinal](const PostingBlockHeader& header) {
+            return header.last_ordinal < ordinal;
+            }) - blocks_.begin();
+    }
+    const std::span<const DocumentOrdinal> ordinals = GetOrdinals();
+    const size_t first = std::min(ordinals.size(), first_block * BLOCK_SIZE);
+    const size_t pos = std::lower_bound(ordinals.begin() + first, ordinals.end(), ordinal) - ordinals.begin();
+    return pos == ordinals.size() ? GetBlockCount() : pos / BLOCK_SIZE;
+}
+
+PostingList::Block PostingList::GetBlock(size_t block, BlockBuffer& buffer) const {
+    if (IsCompressed()) {
+        const PostingBlockHeader& header = blocks_[block];
+        decode_block.load(std::memory_order_relaxed)(header, block_data_, term_freq_table_, buffer);
+        return { std::span<const DocumentOrdinal>(buffer.ordinals.data(), header.size),
+            std::span<const double>(buffer.term_freqs.data(), header.size) };
+    }
+    const size_t first = block * BLOCK_SIZE;
+    const size_t size = std::min(BLOCK_SIZE, GetOrdinals().size() - first);
+    return { GetOrdinals().subspan(first, size), GetTermFreqs().subspan(first, size) };
+}
+
+std::span<const DocumentOrdinal> PostingList::GetOrdinals() const {
+    return mapped_ordinals_.empty() ? std::span<const DocumentOrdinal>(ordinals_) : mapped_ordinals_;
+}
+
+std::span<const double> PostingList::GetTermFreqs() const {
+    return mapped_term_freqs_.empty() ? std::span<const double>(term_freqs_) : mapped_term_freqs_;
+}
+
+double PostingList::GetMaxTermFreq() const {
+    return max_term_freq_;
+}
+
+bool PostingList::IsCompressed() const {
+    return !blocks_.empty();
+}
+
+void PostingList::Materialize() {
+    if (IsCompressed()) {
+        ordinals_.reserve(compressed_size_);
+        term_freqs_.reserve(compressed_size_);
+        ForEach([this](DocumentOrdinal ordinal, double term_freq) {
+            ordinals_.push_back(ordinal);
+            term_freqs_.push_back(term_freq);
+            });
+        blocks_ = {};
+        block_data_ = nullptr;
+        term_freq_table_ = nullptr;
+        compressed_size_ = 0;
+        return;
+    }
+    if (mapped_ordinals_.empty()) {
+        return;
+    }
+    ordinals_.assign(mapped_ordinals_.begin(), mapped_ordinals_.end());
+    term_freqs_.assign(mapped_term_freqs_.begin(), mapped_term_freqs_.end());
+    mapped_ordinals_ = {};
+    mapped_term_freqs_ = {};
+}
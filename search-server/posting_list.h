@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+using DocumentOrdinal = uint32_t;
+
+//   ,    :  last_ordinal 
+//  ,   .    
+//  ordinal_bits    ( ),   
+//   term_freq_bits     .
+struct PostingBlockHeader {
+    uint64_t offset;
+    DocumentOrdinal first_ordinal;
+    DocumentOrdinal last_ordinal;
+    uint16_t size;
+    uint8_t ordinal_bits;
+    uint8_t term_freq_bits;
+};
+
+class PostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+    //         :
+    //         
+    static constexpr size_t BLOCK_PADDING = 8;
+
+    //  .      ,
+    //      .
+    struct Block {
+        std::span<const DocumentOrdinal> ordinals;
+        std::span<const double> term_freqs;
+    };
+
+    struct alignas(32) BlockBuffer {
+        std::array<DocumentOrdinal, BLOCK_SIZE> ordinals;
+        std::array<double, BLOCK_SIZE> term_freqs;
+    };
+
+    PostingList() = default;
+
+    // ,       (,  
+    //  ).        .
+    PostingList(std::span<const DocumentOrdinal> ordinals, std::span<const double> term_freqs, double max_term_freq);
+
+    //     blocks,     block_data,
+    //      term_freq_table
+    PostingList(std::span<const PostingBlockHeader> blocks, const uint8_t* block_data, const double* term_freq_table,
+        size_t size, double max_term_freq);
+
+    //    block_data  blocks. term_freq_codes -  
+    //  ,     .
+    static void EncodeBlocks(std::span<const DocumentOrdinal> ordinals, std::span<const uint32_t> term_freq_codes,
+        std::vector<uint8_t>& block_data, std::vector<PostingBlockHeader>& blocks);
+
+    //    ,    .
+    //        
+    static bool IsVectorDecodingSupported();
+
+    static void SetVectorDecoding(bool is_enabled);
+
+    void Add(DocumentOrdinal ordinal, double term_freq);
+
+    void Remove(DocumentOrdinal ordinal);
+
+    bool Contains(DocumentOrdinal ordinal) const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    size_t GetBlockCount() const;
+
+    DocumentOrdinal GetBlockLastOrdinal(size_t block) const;
+
+    //     first_block,     ordinal,
+    //  GetBlockCount(),   
+    size_t FindBlock(DocumentOrdinal ordinal, size_t first_block = 0) const;
+
+    Block GetBlock(size_t block, BlockBuffer& buffer) const;
+
+    //  action(ordinal, term_freq)    [first, last)
+    template <typename Action>
+    void ForEach(DocumentOrdinal first, DocumentOrdinal last, Action action) const;
+
+    template <typename Action>
+    void ForEach(Action action) const;
+
+    double GetMaxTermFreq() const;
+
+private:
+    std::vector<DocumentOrdinal> ordinals_;
+    std::vector<double> term_freqs_;
+    std::span<const DocumentOrdinal> mapped_ordinals_;
+    std::span<const double> mapped_term_freqs_;
+    std::span<const PostingBlockHeader> blocks_;
+    const uint8_t* block_data_ = nullptr;
+    const double* term_freq_table_ = nullptr;
+    size_t compressed_size_ = 0;
+    double max_term_freq_ = 0.0;
+
+    std::span<const DocumentOrdinal> GetOrdinals() const;
+
+    std::span<const double> GetTermFreqs() const;
+
+    bool IsCompressed() const;
+
+    void Materialize();
+};
+
+template <typename Action>
+void PostingList::ForEach(DocumentOrdinal first, DocumentOrdinal last, Action action) const {
+    if (!IsCompressed()) {
+        const std::span<const DocumentOrdinal> ordinals = GetOrdinals();
+        const std::span<const double> term_freqs = GetTermFreqs();
+        for (size_t i = std::lower_bound(ordinals.begin(), ordinals.end(), first) - ordinals.begin();
+            i < ordinals.size() && ordinals[i] < last; ++i) {
+            action(ordinals[i], term_freqs[i]);
+        }
+        return;
+    }
+    BlockBuffer buffer;
+    for (size_t block = FindBlock(first); block < blocks_.size() && blocks_[block].first_ordinal < last; ++block) {
+        const Block postings = GetBlock(block, buffer);
+        for (size_t i = std::lower_bound(postings.ordinals.begin(), postings.ordinals.end(), first) - postings.ordinals.begin();
+            i < postings.ordinals.size() && postings.ordinals[i] < last; ++i) {
+            action(postings.ordinals[i], postings.term_freqs[i]);
+        }
+    }
+}
+
+template <typename Action>
+void PostingList::ForEach(Action action) const {
+    ForEach(0, std::numeric_limits<DocumentOrdinal>::max(), action);
+}
@@ -1,11 +1,78 @@
 #include "process_queries.h"
 
+#include <atomic>
+#include <memory>
+
+namespace {
+
+BatchExecutor& GetQueryExecutor() {
+    static BatchExecutor executor;
+    return executor;
+}
+
+//     ,   - 
+//    ,       
+SearchServer::QueryContext& GetThreadQueryContext() {
+    thread_local SearchServer::QueryContext context;
+    return context;
+}
+
+//  ,   .    ,
+//   
+struct SplitQueryState {
+    SplitQueryState(SearchServer::PreparedQuery query, std::vector<SearchServer::QueryPart> parts)
+        : query(std::move(query))
+        , parts(std::move(parts))
+        , part_results(this->parts.size())
+        , remaining_part_count(this->parts.size()) {
+    }
+
+    SearchServer::PreparedQuery query;
+    std::vector<SearchServer::QueryPart> parts;
+    std::vector<std::vector<Document>> part_results;
+    std::atomic<size_t> remaining_part_count;
+};
+
+}  // namespace
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries) {
+    return ProcessQueries(search_server, queries, GetQueryExecutor());
+}
+
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    BatchExecutor& executor) {
     std::vector<std::vector<Document>> result(queries.size());
-    std::transform(std::execution::par, queries.begin(), queries.end(), result.begin(), [&search_server](std::string query) {
-        return search_server.FindTopDocuments(std::execution::par, query);
+    executor.Run(queries.size(), [&](size_t i) {
+        SearchServer::PreparedQuery query = search_server.PrepareQuery(queries[i]);
+        std::vector<SearchServer::QueryPart> parts;
+        if (executor.GetThreadCount() > 1 && query.GetPostingCount() > SPLIT_QUERY_POSTING_COUNT) {
+            parts = search_server.SplitQuery(query, SPLIT_QUERY_POSTING_COUNT);
+        }
+        if (parts.size() <= 1) {
+            result[i] = search_server.FindTopDocuments(GetThreadQueryContext(), std::execution::seq, query);
+            return;
+        }
+
+        auto state = std::make_shared<SplitQueryState>(std::move(query), std::move(parts));
+        for (size_t part = 0; part < state->parts.size(); ++part) {
+            executor.Spawn([&search_server, &result, i, part, state] {
+                state->part_results[part] = search_server.FindTopDocuments(
+                    GetThreadQueryContext(), state->query, state->parts[part]);
+                if (state->remaining_part_count.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                    return;
+                }
+                std::vector<Document> documents;
+                for (const std::vector<Document>& part_result : state->part_results) {
+                    documents.insert(documents.end(), part_result.begin(), part_result.end());
+                }
+                search_server.MergeTopDocuments(documents);
+                result[i] = std::move(documents);
+                });
+        }
         });
     return result;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "batch_executor.h"
 #include "search_server.h"
 
 #include <numeric>
@@ -8,10 +9,21 @@
 #include <string>
 #include <list>
 
+//        ,   
+//    ,    
+const size_t SPLIT_QUERY_POSTING_COUNT = 1 << 16;
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+//     executor.      , 
+//  SPLIT_QUERY_POSTING_COUNT    
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    BatchExecutor& executor);
+
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+struct ZoneInfo {
+    std::string name;
+    std::string file;
+    int line = 0;
+};
+
+//     .    , 
+//     ;    
+struct ZoneCounters {
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> total = 0;
+    std::atomic<uint64_t> min = std::numeric_limits<uint64_t>::max();
+    std::atomic<uint64_t> max = 0;
+
+    void Add(uint64_t duration) {
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+        if (duration < min.load(std::memory_order_relaxed)) {
+            min.store(duration, std::memory_order_relaxed);
+        }
+        if (duration > max.load(std::memory_order_relaxed)) {
+            max.store(duration, std::memory_order_relaxed);
+        }
+    }
+
+    void Clear() {
+        count.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+};
+
+struct TraceEvent {
+    uint32_t zone = 0;
+    uint32_t thread = 0;
+    Profiler::Clock::time_point start_time;
+    std::chrono::nanoseconds duration{};
+};
+
+struct ThreadState;
+
+struct Registry {
+    std::mutex mutex;
+    std::deque<ZoneInfo> zones;
+    std::vector<ThreadState*> threads;
+    uint32_t next_thread = 0;
+    //     
+    std::array<Profiler::ZoneStats, Profiler::MAX_ZONE_COUNT> finished_stats;
+    std::vector<TraceEvent> finished_events;
+
+    std::atomic<bool> is_tracing = false;
+    std::atomic<size_t> trace_event_count = 0;
+    std::atomic<size_t> max_trace_event_count = 0;
+    Profiler::Clock::time_point trace_start_time;
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+void AddZoneStats(Profiler::ZoneStats& stats, uint64_t count, uint64_t total, uint64_t min, uint64_t max) {
+    if (count == 0) {
+        return;
+    }
+    stats.min = stats.count == 0 ? std::chrono::nanoseconds(min) : std::min(stats.min, std::chrono::nanoseconds(min));
+    stats.max = std::max(stats.max, std::chrono::nanoseconds(max));
+    stats.count += count;
+    stats.total += std::chrono::nanoseconds(total);
+}
+
+struct ThreadState {
+    uint32_t thread = 0;
+    std::array<ZoneCounters, Profiler::MAX_ZONE_COUNT> zones;
+    //    WriteTrace   
+    std::mutex events_mutex;
+    std::vector<TraceEvent> events;
+
+    ThreadState() {
+        Registry& registry = GetRegistry();
+        std::lock_guard guard(registry.mutex);
+        thread = registry.next_thread++;
+        registry.threads.push_back(this);
+    }
+
+    ~ThreadState() {
+        Registry& registry = GetRegistry();
+        std::lock_guard guard(registry.mutex);
+        for (size_t zone = 0; zone < registry.zones.size(); ++zone) {
+            const ZoneCounters& counters = zones[zone];
+            AddZoneStats(registry.finished_stats[zone], counters.count.load(), counters.total.load(),
+                counters.min.load(), counters.max.load());
+        }
+        std::lock_guard events_guard(events_mutex);
+        registry.finished_events.insert(registry.finished_events.end(), events.begin(), events.end());
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+    }
+};
+
+ThreadState& GetThreadState() {
+    thread_local ThreadState state;
+    return state;
+}
+
+void WriteJsonString(std::ostream& out, std::string_view text) {
+    out << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u"sv << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        }
+        else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+size_t Profiler::RegisterZone(std::string_view name, std::string_view file, int line) {
+    Registry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    const auto it = std::find_if(registry.zones.begin(), registry.zones.end(), [&](const ZoneInfo& zone) {
+        return zone.line == line && zone.file == file && zone.name == name;
+        });
+    if (it != registry.zones.end()) {
+        return static_cast<size_t>(it - registry.zones.begin());
+    }
+    if (registry.zones.size() == MAX_ZONE_COUNT) {
+        throw std::length_error("Too many profile zones"s);
+    }
+    registry.zones.push_back({ std::string(name), std::string(file), line });
+    return registry.zones.size() - 1;
+}
+
+void Profiler::Record(size_t zone, Clock::time_point start_time, Clock::time_point end_time) {
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+    ThreadState& state = GetThreadState();
+    state.zones[zone].Add(static_cast<uint64_t>(duration.count()));
+
+    Registry& registry = GetRegistry();
+    if (!registry.is_tracing.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (registry.trace_event_count.fetch_add(1, std::memory_order_relaxed)
+        >= registry.max_trace_event_count.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard guard(state.events_mutex);
+    state.events.push_back({ static_cast<uint32_t>(zone), state.thread, start_time, duration });
+}
+
+std::vector<Profiler::ZoneStats> Profiler::GetStats() {
+    Registry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    std::vector<ZoneStats> stats(registry.finished_stats.begin(), registry.finished_stats.begin() + registry.zones.size());
+    for (size_t zone = 0; zone < registry.zones.size(); ++zone) {
+        stats[zone].name = registry.zones[zone].name;
+        stats[zone].file = registry.zones[zone].file;
+        stats[zone].line = registry.zones[zone].line;
+        for (const ThreadState* state : registry.threads) {
+            const ZoneCounters& counters = state->zones[zone];
+            AddZoneStats(stats[zone], counters.count.load(std::memory_order_relaxed),
+                counters.total.load(std::memory_order_relaxed), counters.min.load(std::memory_order_relaxed),
+                counters.max.load(std::memory_order_relaxed));
+        }
+    }
+    stats.erase(std::remove_if(stats.begin(), stats.end(), [](const ZoneStats& zone) {
+        return zone.count == 0;
+        }), stats.end());
+    std::sort(stats.begin(), stats.end(), [](const ZoneStats& lhs, const ZoneStats& rhs) {
+        return lhs.total > rhs.total;
+        });
+    return stats;
+}
+
+void Profiler::PrintReport(std::ostream& out) {
+    const std::vector<ZoneStats> stats = GetStats();
+    out << std::left << std::setw(40) << "zone"sv << std::right << std::setw(10) << "count"sv
+        << std::setw(14) << "total, ms"sv << std::setw(12) << "mean, ns"sv << std::setw(12) << "min, ns"sv
+        << std::setw(14) << "max, ns"sv << "  location"sv << std::endl;
+    for (const ZoneStats& zone : stats) {
+        out << std::left << std::setw(40) << zone.name << std::right << std::setw(10) << zone.count
+            << std::setw(14) << std::fixed << std::setprecision(3) << zone.total.count() / 1e6
+            << std::setw(12) << zone.total.count() / zone.count << std::setw(12) << zone.min.count()
+            << std::setw(14) << zone.max.count() << "  "sv << zone.file << ':' << zone.line << std::endl;
+    }
+}
+
+void Profiler::StartTrace(size_t max_event_count) {
+    Registry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    registry.finished_events.clear();
+    for (ThreadState* state : registry.threads) {
+        std::lock_guard events_guard(state->events_mutex);
+        state->events.clear();
+    }
+    registry.max_trace_event_count = max_event_count;
+    registry.trace_event_count = 0;
+    registry.trace_start_time = Clock::now();
+    registry.is_tracing = true;
+}
+
+void Profiler::StopTrace() {
+    GetRegistry().is_tracing = false;
+}
+
+void Profiler::WriteTrace(std::ostream& out) {
+    Registry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    std::vector<TraceEvent> events = registry.finished_events;
+    for (ThreadState* state : registry.threads) {
+        std::lock_guard events_guard(state->events_mutex);
+        events.insert(events.end(), state->events.begin(), state->events.end());
+    }
+    std::sort(events.begin(), events.end(), [](const TraceEvent& lhs, const TraceEvent& rhs) {
+        return lhs.start_time < rhs.start_time;
+        });
+
+    //   trace event   
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":["sv;
+    bool is_first = true;
+    for (const TraceEvent& event : events) {
+        if (!is_first) {
+            out << ',';
+        }
+        is_first = false;
+        const double start = std::chrono::duration<double, std::micro>(event.start_time - registry.trace_start_time).count();
+        const double duration = std::chrono::duration<double, std::micro>(event.duration).count();
+        out << "\n{\"name\":"sv;
+        WriteJsonString(out, registry.zones[event.zone].name);
+        out << ",\"cat\":\"search_server\",\"ph\":\"X\",\"pid\":0,\"tid\":"sv << event.thread
+            << ",\"ts\":"sv << std::fixed << std::setprecision(3) << start << ",\"dur\":"sv << duration << '}';
+    }
+    out << "\n]}"sv << std::endl;
+}
+
+void Profiler::Reset() {
+    Registry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    registry.finished_stats = {};
+    registry.finished_events.clear();
+    registry.trace_event_count = 0;
+    for (ThreadState* state : registry.threads) {
+        for (ZoneCounters& counters : state->zones) {
+            counters.Clear();
+        }
+        std::lock_guard events_guard(state->events_mutex);
+        state->events.clear();
+    }
+}
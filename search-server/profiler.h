@@ -0,0 +1,105 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log_duration.h"
+
+/**
+ *          , 
+ * LOG_DURATION,    :     
+ *        .   
+ *   Profiler::PrintReport,    
+ * Profiler::WriteTrace      Chrome trace.
+ *
+ *  ,    SEARCH_SERVER_PROFILE,
+ *            .
+ *
+ *  :
+ *
+ *  void Task() {
+ *      PROFILE_SCOPE("Task");
+ *      ...
+ *  }
+ *
+ *  int main() {
+ *      Profiler::StartTrace();
+ *      Task();
+ *      Profiler::PrintReport(std::cerr);
+ *      std::ofstream trace("trace.json"s);
+ *      Profiler::WriteTrace(trace);
+ *  }
+ */
+#ifdef SEARCH_SERVER_PROFILE
+#define PROFILE_SCOPE(x)                                                                        \
+    static const size_t PROFILE_CONCAT(profileZone, __LINE__) =                                 \
+        Profiler::RegisterZone(x, __FILE__, __LINE__);                                          \
+    ProfileScope UNIQUE_VAR_NAME_PROFILE(PROFILE_CONCAT(profileZone, __LINE__))
+#else
+#define PROFILE_SCOPE(x) static_cast<void>(0)
+#endif
+
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //     PROFILE_SCOPE  
+    static constexpr size_t MAX_ZONE_COUNT = 256;
+
+    struct ZoneStats {
+        std::string name;
+        std::string file;
+        int line = 0;
+        uint64_t count = 0;
+        std::chrono::nanoseconds total{};
+        std::chrono::nanoseconds min{};
+        std::chrono::nanoseconds max{};
+    };
+
+    //    ;     
+    // (,    )    
+    static size_t RegisterZone(std::string_view name, std::string_view file, int line);
+
+    static void Record(size_t zone, Clock::time_point start_time, Clock::time_point end_time);
+
+    //  ,    ,    
+    static std::vector<ZoneStats> GetStats();
+
+    static void PrintReport(std::ostream& out);
+
+    //    ,   max_event_count
+    static void StartTrace(size_t max_event_count = 1'000'000);
+
+    static void StopTrace();
+
+    //      Chrome trace event (chrome://tracing, Perfetto)
+    static void WriteTrace(std::ostream& out);
+
+    static void Reset();
+};
+
+class ProfileScope {
+public:
+    using Clock = Profiler::Clock;
+
+    explicit ProfileScope(size_t zone)
+        : zone_(zone) {
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ~ProfileScope() {
+        Profiler::Record(zone_, start_time_, Clock::now());
+    }
+
+private:
+    const size_t zone_;
+    const Clock::time_point start_time_ = Clock::now();
+};
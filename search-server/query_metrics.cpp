@@ -0,0 +1,135 @@
+#include "query_metrics.h"
+
+#include <memory>
+
+using namespace std::literals;
+
+void QueryMetrics::Sample::Start() {
+    start_time = Clock::now();
+    phase_start_time = start_time;
+    phase_nanoseconds.fill(0);
+    measured_phases = 0;
+    postings_scanned = 0;
+    documents_scored = 0;
+    documents_filtered = 0;
+}
+
+void QueryMetrics::Sample::EndPhase(Phase phase) {
+    const Clock::time_point now = Clock::now();
+    phase_nanoseconds[static_cast<size_t>(phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        now - phase_start_time).count();
+    measured_phases |= uint32_t{ 1 } << static_cast<size_t>(phase);
+    phase_start_time = now;
+}
+
+const QueryMetrics::PhaseStats& QueryMetrics::Snapshot::GetPhase(Phase phase) const {
+    return phases[static_cast<size_t>(phase)];
+}
+
+QueryMetrics::~QueryMetrics() {
+    for (std::atomic<Shard*>& shard : shards_) {
+        delete shard.load();
+    }
+}
+
+void QueryMetrics::Record(const Sample& sample, size_t result_count) {
+    const uint64_t total_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - sample.start_time).count();
+    Shard& shard = GetShard();
+    for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        if (sample.measured_phases >> phase & 1) {
+            shard.phases[phase].Add(sample.phase_nanoseconds[phase]);
+        }
+    }
+    shard.phases[static_cast<size_t>(Phase::TOTAL)].Add(total_nanoseconds);
+    shard.counters[QUERY_COUNT].fetch_add(1, std::memory_order_relaxed);
+    shard.counters[POSTINGS_SCANNED].fetch_add(sample.postings_scanned, std::memory_order_relaxed);
+    shard.counters[DOCUMENTS_SCORED].fetch_add(sample.documents_scored, std::memory_order_relaxed);
+    shard.counters[DOCUMENTS_FILTERED].fetch_add(sample.documents_filtered, std::memory_order_relaxed);
+    shard.counters[DOCUMENTS_RETURNED].fetch_add(result_count, std::memory_order_relaxed);
+}
+
+QueryMetrics::Snapshot QueryMetrics::GetSnapshot() const {
+    auto phases = std::make_unique<std::array<LatencyHistogram, PHASE_COUNT>>();
+    std::array<uint64_t, COUNTER_COUNT> counters{};
+    for (const std::atomic<Shard*>& shard_pointer : shards_) {
+        const Shard* shard = shard_pointer.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+            (*phases)[phase].Merge(shard->phases[phase]);
+        }
+        for (size_t counter = 0; counter < COUNTER_COUNT; ++counter) {
+            counters[counter] += shard->counters[counter].load(std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot;
+    for (size_t phase = 0; phase < PHASE_COUNT; ++phase) {
+        const LatencyHistogram& histogram = (*phases)[phase];
+        PhaseStats& stats = snapshot.phases[phase];
+        stats.count = histogram.GetCount();
+        if (stats.count == 0) {
+            continue;
+        }
+        stats.mean = std::chrono::nanoseconds(histogram.GetSum() / stats.count);
+        stats.p50 = std::chrono::nanoseconds(histogram.GetValueAtQuantile(0.5));
+        stats.p99 = std::chrono::nanoseconds(histogram.GetValueAtQuantile(0.99));
+        stats.p999 = std::chrono::nanoseconds(histogram.GetValueAtQuantile(0.999));
+    }
+    snapshot.query_count = counters[QUERY_COUNT];
+    snapshot.postings_scanned = counters[POSTINGS_SCANNED];
+    snapshot.documents_scored = counters[DOCUMENTS_SCORED];
+    snapshot.documents_filtered = counters[DOCUMENTS_FILTERED];
+    snapshot.documents_returned = counters[DOCUMENTS_RETURNED];
+    return snapshot;
+}
+
+void QueryMetrics::Clear() {
+    for (std::atomic<Shard*>& shard_pointer : shards_) {
+        Shard* shard = shard_pointer.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (LatencyHistogram& histogram : shard->phases) {
+            histogram.Clear();
+        }
+        for (std::atomic<uint64_t>& counter : shard->counters) {
+            counter.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::string_view QueryMetrics::GetPhaseName(Phase phase) {
+    switch (phase) {
+    case Phase::PARSE:
+        return "parse"sv;
+    case Phase::RESOLVE:
+        return "resolve"sv;
+    case Phase::TRAVERSE:
+        return "traverse"sv;
+    case Phase::TOP_K:
+        return "top-k"sv;
+    case Phase::MATERIALIZE:
+        return "materialize"sv;
+    case Phase::TOTAL:
+        return "total"sv;
+    }
+    return "unknown"sv;
+}
+
+QueryMetrics::Shard& QueryMetrics::GetShard() {
+    static std::atomic<size_t> next_thread_index = 0;
+    thread_local const size_t thread_index = next_thread_index.fetch_add(1, std::memory_order_relaxed);
+    std::atomic<Shard*>& shard_pointer = shards_[thread_index % MAX_SHARD_COUNT];
+    Shard* shard = shard_pointer.load(std::memory_order_acquire);
+    if (shard) {
+        return *shard;
+    }
+    auto new_shard = std::make_unique<Shard>();
+    if (shard_pointer.compare_exchange_strong(shard, new_shard.get(), std::memory_order_acq_rel)) {
+        return *new_shard.release();
+    }
+    return *shard;
+}
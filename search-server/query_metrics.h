@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "latency_histogram.h"
+
+//   :      
+//  .      ,   
+//        -;   .
+class QueryMetrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //          TRAVERSE
+    enum class Phase {
+        PARSE = 0,
+        RESOLVE = 1,
+        TRAVERSE = 2,
+        TOP_K = 3,
+        MATERIALIZE = 4,
+        TOTAL = 5,
+    };
+    static constexpr size_t PHASE_COUNT = 6;
+
+    //   .      
+    struct Sample {
+        Clock::time_point start_time;
+        Clock::time_point phase_start_time;
+        std::array<uint64_t, PHASE_COUNT> phase_nanoseconds{};
+        uint32_t measured_phases = 0;
+        uint64_t postings_scanned = 0;
+        uint64_t documents_scored = 0;
+        uint64_t documents_filtered = 0;
+
+        void Start();
+
+        //   phase    ;   
+        void EndPhase(Phase phase);
+    };
+
+    struct PhaseStats {
+        uint64_t count = 0;
+        std::chrono::nanoseconds mean{};
+        std::chrono::nanoseconds p50{};
+        std::chrono::nanoseconds p99{};
+        std::chrono::nanoseconds p999{};
+    };
+
+    struct Snapshot {
+        std::array<PhaseStats, PHASE_COUNT> phases;
+        uint64_t query_count = 0;
+        uint64_t postings_scanned = 0;
+        // ,    
+        uint64_t documents_scored = 0;
+        // ,     
+        uint64_t documents_filtered = 0;
+        uint64_t documents_returned = 0;
+
+        const PhaseStats& GetPhase(Phase phase) const;
+    };
+
+    QueryMetrics() = default;
+
+    QueryMetrics(const QueryMetrics&) = delete;
+
+    QueryMetrics& operator=(const QueryMetrics&) = delete;
+
+    ~QueryMetrics();
+
+    //  :  TOTAL   sample.Start()
+    void Record(const Sample& sample, size_t result_count);
+
+    Snapshot GetSnapshot() const;
+
+    void Clear();
+
+    static std::string_view GetPhaseName(Phase phase);
+
+private:
+    static constexpr size_t MAX_SHARD_COUNT = 64;
+
+    enum Counter {
+        QUERY_COUNT,
+        POSTINGS_SCANNED,
+        DOCUMENTS_SCORED,
+        DOCUMENTS_FILTERED,
+        DOCUMENTS_RETURNED,
+        COUNTER_COUNT,
+    };
+
+    struct Shard {
+        std::array<LatencyHistogram, PHASE_COUNT> phases;
+        std::array<std::atomic<uint64_t>, COUNTER_COUNT> counters{};
+    };
+
+    //          
+    std::array<std::atomic<Shard*>, MAX_SHARD_COUNT> shards_{};
+
+    Shard& GetShard();
+};
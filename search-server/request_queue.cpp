@@ -1,23 +1,39 @@
 #include "request_queue.h"
 
 int RequestQueue::GetNoResultRequests() const {
-    int empty_requests = 0;
-    for (QueryResult result_ : requests_) {
-        if (result_.responce_ == 0) {
-            ++empty_requests;
-        }
-    }
-    return empty_requests;
+    return no_result_requests_.load(std::memory_order_relaxed);
 }
 
 
 int RequestQueue::TotalRequets() const {    
-    return requests_.size();
+    return total_requests_.load(std::memory_order_relaxed);
 }
 
+int RequestQueue::GetStatusRequests(DocumentStatus status) const {
+    return kind_requests_[static_cast<size_t>(status)].load(std::memory_order_relaxed);
+}
+
+int RequestQueue::GetPredicateRequests() const {
+    return kind_requests_[PREDICATE_REQUEST_KIND].load(std::memory_order_relaxed);
+}
 
-void RequestQueue::DequeRequests() {
-    if (requests_.size() > min_in_day_) {
-        requests_.pop_front();
+
+void RequestQueue::AddRequest(size_t kind, bool is_empty) {
+    std::lock_guard guard(mutex_);
+    QueryResult& result = requests_[next_request_];
+    if (total_requests_.load(std::memory_order_relaxed) == min_in_day_) {
+        if (result.is_empty) {
+            no_result_requests_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        kind_requests_[result.kind].fetch_sub(1, std::memory_order_relaxed);
+    }
+    else {
+        total_requests_.fetch_add(1, std::memory_order_relaxed);
+    }
+    result = { is_empty, static_cast<uint8_t>(kind) };
+    if (is_empty) {
+        no_result_requests_.fetch_add(1, std::memory_order_relaxed);
     }
+    kind_requests_[kind].fetch_add(1, std::memory_order_relaxed);
+    next_request_ = (next_request_ + 1) % min_in_day_;
 }
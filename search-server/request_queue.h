@@ -1,5 +1,9 @@
 #pragma once
-#include <stack>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <execution>
@@ -7,6 +11,9 @@
 #include "document.h"
 #include "search_server.h"
 
+//      (   ).  - 
+//   ,     , 
+//            .
 class RequestQueue {
 public:
 
@@ -19,39 +26,49 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
 
         std::vector<Document> doc = server.FindTopDocuments(raw_query, document_predicate);
-        requests_.push_back({ doc.size(), raw_query });
-        DequeRequests();
+        AddRequest(PREDICATE_REQUEST_KIND, doc.empty());
         return doc;     
     }
 
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status) {
         std::vector<Document> doc = server.FindTopDocuments(std::execution::par, raw_query, status);
-        requests_.push_back({ doc.size(), raw_query});
-        DequeRequests();
+        AddRequest(static_cast<size_t>(status), doc.empty());
         return doc;
     }
 
     std::vector<Document> AddFindRequest(const std::string& raw_query) {
-        std::vector<Document> doc = server.FindTopDocuments(std::execution::par, raw_query);
-        requests_.push_back({ doc.size(), raw_query });
-        DequeRequests();
-        return doc;
+        return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
     }
 
     int GetNoResultRequests() const;
 
     int TotalRequets() const;
 
+    //      
+    int GetStatusRequests(DocumentStatus status) const;
+
+    //     
+    int GetPredicateRequests() const;
+
 
 private:
+    //  :    
+    static constexpr size_t PREDICATE_REQUEST_KIND = static_cast<size_t>(DocumentStatus::REMOVED) + 1;
+    static constexpr size_t REQUEST_KIND_COUNT = PREDICATE_REQUEST_KIND + 1;
+
     struct QueryResult {
-        size_t responce_;
-        std::string request;
+        bool is_empty = false;
+        uint8_t kind = 0;
     };
-    std::deque<QueryResult> requests_;
     const static int min_in_day_ = 1440;
     const SearchServer& server;
+    //   ;    
+    std::mutex mutex_;
+    std::array<QueryResult, min_in_day_> requests_;
+    size_t next_request_ = 0;
+    std::atomic<int> total_requests_ = 0;
+    std::atomic<int> no_result_requests_ = 0;
+    std::array<std::atomic<int>, REQUEST_KIND_COUNT> kind_requests_{};
 
-    void DequeRequests();
+    void AddRequest(size_t kind, bool is_empty);
 };
-
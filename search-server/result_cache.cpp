@@ -0,0 +1,124 @@
+#include "result_cache.h"
+
+#include <functional>
+
+double ResultCache::Stats::GetHitRate() const {
+    const uint64_t lookups = hits + misses;
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+}
+
+ResultCache::ResultCache(size_t shard_count)
+    : shards_(shard_count)
+{
+}
+
+void ResultCache::SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+    const size_t shard_capacity = GetShardCapacity();
+    for (Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        while (shard.entries.size() > shard_capacity) {
+            Erase(shard, std::prev(shard.entries.end()));
+            ++evictions_;
+        }
+    }
+}
+
+size_t ResultCache::GetCapacity() const {
+    return capacity_;
+}
+
+bool ResultCache::IsEnabled() const {
+    return capacity_ > 0;
+}
+
+bool ResultCache::Find(std::string_view key, uint64_t generation, std::vector<Document>& documents) {
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+    const auto position = shard.positions.find(key);
+    if (position == shard.positions.end()) {
+        ++misses_;
+        return false;
+    }
+    const auto it = position->second;
+    if (it->generation != generation) {
+        Erase(shard, it);
+        ++invalidations_;
+        ++misses_;
+        return false;
+    }
+    shard.entries.splice(shard.entries.begin(), shard.entries, it);
+    documents.assign(it->documents.begin(), it->documents.end());
+    ++hits_;
+    return true;
+}
+
+void ResultCache::Insert(std::string_view key, uint64_t generation, const std::vector<Document>& documents) {
+    const size_t shard_capacity = GetShardCapacity();
+    if (shard_capacity == 0) {
+        return;
+    }
+    Shard& shard = GetShard(key);
+    std::lock_guard guard(shard.mutex);
+    if (const auto position = shard.positions.find(key); position != shard.positions.end()) {
+        //      ;    
+        if (position->second->generation >= generation) {
+            return;
+        }
+        Erase(shard, position->second);
+    }
+    shard.entries.push_front({ std::string(key), generation, documents });
+    shard.positions.emplace(shard.entries.front().key, shard.entries.begin());
+    shard.memory_bytes += GetEntryMemory(shard.entries.front());
+    ++insertions_;
+    while (shard.entries.size() > shard_capacity) {
+        Erase(shard, std::prev(shard.entries.end()));
+        ++evictions_;
+    }
+}
+
+void ResultCache::Clear() {
+    for (Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        shard.positions.clear();
+        shard.entries.clear();
+        shard.memory_bytes = 0;
+    }
+}
+
+ResultCache::Stats ResultCache::GetStats() const {
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.insertions = insertions_;
+    stats.evictions = evictions_;
+    stats.invalidations = invalidations_;
+    stats.capacity = capacity_;
+    for (const Shard& shard : shards_) {
+        std::lock_guard guard(shard.mutex);
+        stats.entry_count += shard.entries.size();
+        stats.memory_bytes += shard.memory_bytes;
+    }
+    return stats;
+}
+
+ResultCache::Shard& ResultCache::GetShard(std::string_view key) {
+    return shards_[std::hash<std::string_view>{}(key) % shards_.size()];
+}
+
+size_t ResultCache::GetShardCapacity() const {
+    return (capacity_ + shards_.size() - 1) / shards_.size();
+}
+
+size_t ResultCache::GetEntryMemory(const Entry& entry) {
+    //  ,    -  
+    constexpr size_t NODE_OVERHEAD = 4 * sizeof(void*);
+    return sizeof(Entry) + NODE_OVERHEAD + sizeof(std::pair<std::string_view, std::list<Entry>::iterator>) + NODE_OVERHEAD
+        + entry.key.capacity() + entry.documents.capacity() * sizeof(Document);
+}
+
+void ResultCache::Erase(Shard& shard, std::list<Entry>::iterator it) {
+    shard.memory_bytes -= GetEntryMemory(*it);
+    shard.positions.erase(it->key);
+    shard.entries.erase(it);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+
+//    ,     
+//      LRU.  ,  
+// ,    ,   .
+class ResultCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+        // ,  -   
+        uint64_t invalidations = 0;
+        size_t entry_count = 0;
+        size_t capacity = 0;
+        //   ,    
+        size_t memory_bytes = 0;
+
+        double GetHitRate() const;
+    };
+
+    explicit ResultCache(size_t shard_count = DEFAULT_SHARD_COUNT);
+
+    //   ,    .
+    //   .
+    void SetCapacity(size_t capacity);
+
+    size_t GetCapacity() const;
+
+    bool IsEnabled() const;
+
+    //   documents   key,    generation
+    bool Find(std::string_view key, uint64_t generation, std::vector<Document>& documents);
+
+    void Insert(std::string_view key, uint64_t generation, const std::vector<Document>& documents);
+
+    void Clear();
+
+    Stats GetStats() const;
+
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        //     
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> positions;
+        size_t memory_bytes = 0;
+    };
+
+    std::vector<Shard> shards_;
+    std::atomic<size_t> capacity_ = 0;
+    std::atomic<uint64_t> hits_ = 0;
+    std::atomic<uint64_t> misses_ = 0;
+    std::atomic<uint64_t> insertions_ = 0;
+    std::atomic<uint64_t> evictions_ = 0;
+    std::atomic<uint64_t> invalidations_ = 0;
+
+    Shard& GetShard(std::string_view key);
+
+    size_t GetShardCapacity() const;
+
+    static size_t GetEntryMemory(const Entry& entry);
+
+    static void Erase(Shard& shard, std::list<Entry>::iterator it);
+};
@@ -13,6 +13,215 @@ SearchServer::SearchServer(const std::string_view stop_words_text)
 {
 }
 
+SearchServer::SearchServer(std::shared_ptr<const IndexFile> index_file)
+    : SearchServer(
+        SplitIntoWords(std::string(std::string_view(index_file->GetSection<char>(IndexSection::STOP_WORDS).data(),
+            index_file->GetSection<char>(IndexSection::STOP_WORDS).size()))))
+{
+    const std::span<const uint64_t> settings = index_file->GetSection<uint64_t>(IndexSection::SETTINGS);
+    if (settings.size() != 2) {
+        throw std::invalid_argument("Invalid index file settings"s);
+    }
+    max_result_document_count_ = settings[0];
+    log_sequence_ = settings[1];
+    auto index = std::make_shared<Index>();
+    std::shared_ptr<Segment> segment = MapIndex(index_file);
+    index->document_count = segment->document_ids.size();
+    index->segments.push_back({ std::move(segment), nullptr });
+    UpdateLogTables(*index);
+    index_file_ = std::move(index_file);
+    PublishIndex(std::move(index));
+}
+
+void SearchServer::SaveIndex(const std::string& path) const {
+    std::shared_ptr<const Index> index;
+    uint64_t log_sequence = 0;
+    {
+        std::lock_guard guard(write_mutex_);
+        index = GetIndex();
+        log_sequence = log_sequence_;
+    }
+    WriteIndexFile({ MergeIndex(*index), nullptr }, log_sequence, path);
+}
+
+void SearchServer::OpenOperationLog(const std::string& path) {
+    if (operation_log_) {
+        throw std::logic_error("Operation log is already open"s);
+    }
+    std::vector<OperationLog::Record> records = OperationLog::ReadRecords(OperationLog::GetRotatedPath(path));
+    for (OperationLog::Record& record : OperationLog::ReadRecords(path)) {
+        records.push_back(std::move(record));
+    }
+
+    //       AddDocuments
+    std::vector<NewDocument> documents;
+    uint64_t documents_sequence = 0;
+    const auto add_documents = [this, &documents, &documents_sequence]() {
+        AddDocuments(std::execution::par, documents);
+        documents.clear();
+        std::lock_guard guard(write_mutex_);
+        log_sequence_ = documents_sequence;
+    };
+    for (const OperationLog::Record& record : records) {
+        if (record.sequence <= log_sequence_) {
+            continue;
+        }
+        if (record.type == OperationLog::RecordType::ADD_DOCUMENT) {
+            documents.push_back({ record.document_id, record.text, record.status, record.ratings });
+            documents_sequence = record.sequence;
+            continue;
+        }
+        if (!documents.empty()) {
+            add_documents();
+        }
+        RemoveDocument(record.document_id);
+        std::lock_guard guard(write_mutex_);
+        log_sequence_ = record.sequence;
+    }
+    if (!documents.empty()) {
+        add_documents();
+    }
+
+    std::lock_guard guard(write_mutex_);
+    operation_log_ = std::make_unique<OperationLog>(path, log_sequence_);
+}
+
+void SearchServer::Checkpoint(const std::string& index_path) {
+    std::shared_ptr<const Index> index;
+    uint64_t log_sequence = 0;
+    {
+        std::lock_guard guard(write_mutex_);
+        index = GetIndex();
+        log_sequence = log_sequence_;
+        if (operation_log_) {
+            operation_log_->Rotate();
+        }
+    }
+    // WriteIndexFile ,          
+    // ,         
+    WriteIndexFile({ MergeIndex(*index), nullptr }, log_sequence, index_path);
+    if (operation_log_) {
+        operation_log_->RemoveRotated();
+    }
+}
+
+uint64_t SearchServer::LogAddDocument(int document_id, const std::string_view document, DocumentStatus status,
+    const std::vector<int>& ratings) {
+    if (!operation_log_) {
+        return 0;
+    }
+    log_sequence_ = operation_log_->AppendAddDocument(document_id, document, status, ratings);
+    return log_sequence_;
+}
+
+uint64_t SearchServer::LogRemoveDocument(int document_id) {
+    if (!operation_log_) {
+        return 0;
+    }
+    log_sequence_ = operation_log_->AppendRemoveDocument(document_id);
+    return log_sequence_;
+}
+
+void SearchServer::WaitForOperationLog(uint64_t log_sequence) {
+    if (log_sequence != 0) {
+        operation_log_->WaitDurable(log_sequence);
+    }
+}
+
+void SearchServer::WriteIndexFile(const IndexSegment& index_segment, uint64_t log_sequence, const std::string& path) const {
+    const Segment& segment = *index_segment.segment;
+    IndexFileWriter writer;
+
+    const std::vector<uint64_t> settings = { GetMaxResultDocumentCount(), log_sequence };
+    writer.SetSection(IndexSection::SETTINGS, settings);
+
+    std::string stop_words;
+    for (const std::string& stop_word : stop_words_) {
+        if (!stop_words.empty()) {
+            stop_words.push_back(' ');
+        }
+        stop_words += stop_word;
+    }
+    writer.SetSection(IndexSection::STOP_WORDS, std::span<const char>(stop_words));
+
+    const TermDictionary& terms = *segment.terms;
+    std::string term_bytes;
+    std::vector<uint64_t> term_offsets = { 0 };
+    std::vector<size_t> term_hashes;
+    std::vector<uint64_t> posting_offsets = { 0 };
+    std::vector<DocumentOrdinal> posting_ordinals;
+    std::vector<double> posting_term_freqs;
+    std::vector<double> posting_max_term_freqs;
+    for (TermId term_id = 0; term_id < terms.size(); ++term_id) {
+        term_bytes += terms.GetTerm(term_id);
+        term_offsets.push_back(term_bytes.size());
+        term_hashes.push_back(terms.GetTermHash(term_id));
+        const PostingList& postings = segment.GetPostings(term_id);
+        postings.ForEach([&](DocumentOrdinal ordinal, double term_freq) {
+            if (!index_segment.IsDeleted(ordinal)) {
+                posting_ordinals.push_back(ordinal);
+                posting_term_freqs.push_back(term_freq);
+            }
+            });
+        posting_offsets.push_back(posting_ordinals.size());
+        //      ,      
+        posting_max_term_freqs.push_back(postings.GetMaxTermFreq());
+    }
+    writer.SetSection(IndexSection::TERM_BYTES, std::span<const char>(term_bytes));
+    writer.SetSection(IndexSection::TERM_OFFSETS, term_offsets);
+    writer.SetSection(IndexSection::TERM_HASHES, term_hashes);
+    writer.SetSection(IndexSection::TERM_SLOTS, terms.GetSlots());
+    writer.SetSection(IndexSection::POSTING_OFFSETS, posting_offsets);
+    writer.SetSection(IndexSection::POSTING_ORDINALS, posting_ordinals);
+    writer.SetSection(IndexSection::POSTING_TERM_FREQS, posting_term_freqs);
+    writer.SetSection(IndexSection::POSTING_MAX_TERM_FREQS, posting_max_term_freqs);
+
+    std::vector<int> document_ids;
+    std::vector<DocumentOrdinal> document_ordinals;
+    for (size_t i = 0; i < segment.document_ids.size(); ++i) {
+        if (!index_segment.IsDeleted(segment.document_ordinals[i])) {
+            document_ids.push_back(segment.document_ids[i]);
+            document_ordinals.push_back(segment.document_ordinals[i]);
+        }
+    }
+    writer.SetSection(IndexSection::DOCUMENT_IDS, document_ids);
+    writer.SetSection(IndexSection::DOCUMENT_ORDINALS, document_ordinals);
+    writer.SetSection(IndexSection::ORDINAL_DOCUMENT_IDS, std::span<const int>(segment.ordinal_to_document_id));
+    writer.SetSection(IndexSection::ORDINAL_RATINGS, std::span<const int>(segment.ordinal_ratings));
+    writer.SetSection(IndexSection::ORDINAL_STATUSES, std::span<const DocumentStatus>(segment.ordinal_statuses));
+
+    std::string texts;
+    std::vector<uint64_t> text_offsets = { 0 };
+    std::vector<TermId> document_terms;
+    std::vector<uint64_t> document_term_offsets = { 0 };
+    std::vector<double> word_freqs;
+    for (DocumentOrdinal ordinal = 0; ordinal < segment.ordinal_to_document_id.size(); ++ordinal) {
+        double word_freq = 0.0;
+        if (!index_segment.IsDeleted(ordinal)) {
+            const std::vector<TermId> terms = segment.GetDocumentTerms(ordinal);
+            document_terms.insert(document_terms.end(), terms.begin(), terms.end());
+            if (const DocumentData* document_data = segment.FindStoredDocument(ordinal)) {
+                texts += document_data->text.text;
+                word_freq = document_data->freq.empty() ? 0.0 : document_data->freq.begin()->second;
+            }
+            else {
+                texts += segment.mapped->GetText(ordinal);
+                word_freq = segment.mapped->word_freqs[ordinal];
+            }
+        }
+        text_offsets.push_back(texts.size());
+        document_term_offsets.push_back(document_terms.size());
+        word_freqs.push_back(word_freq);
+    }
+    writer.SetSection(IndexSection::DOCUMENT_TEXT_OFFSETS, text_offsets);
+    writer.SetSection(IndexSection::DOCUMENT_TEXTS, std::span<const char>(texts));
+    writer.SetSection(IndexSection::DOCUMENT_TERM_OFFSETS, document_term_offsets);
+    writer.SetSection(IndexSection::DOCUMENT_TERMS, document_terms);
+    writer.SetSection(IndexSection::DOCUMENT_WORD_FREQS, word_freqs);
+
+    writer.Write(path);
+}
+
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const {
     return FindTopDocuments(std::execution::seq, raw_query, status);
 }
@@ -23,53 +232,218 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
 
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status,
     const std::vector<int>& ratings) {
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
-        throw std::invalid_argument("Invalid document_id"s);
-    }
+    PROFILE_SCOPE("SearchServer::AddDocument");
+    std::unique_lock guard(write_mutex_);
+    auto index = std::make_shared<Index>(*GetIndex());
+    CheckNewDocumentIds(*index, { document_id });
+    CheckDocumentText(document);
 
-    documents_storage.push_back(std::string(document));
-    const auto words = SplitIntoWordsNoStop(documents_storage.back());
+    TextArena::StoredText text = documents_storage.Store(document);
+    std::vector<std::string_view> words;
+    SplitIntoWordsNoStop(text.text, words);
 
+    std::shared_ptr<Segment> segment;
+    if (!index->segments.empty() && !index->segments.back().segment->is_sealed) {
+        segment = std::make_shared<Segment>(*index->segments.back().segment);
+    }
+    else {
+        segment = MakeSegment();
+        index->segments.emplace_back();
+    }
+    std::shared_ptr<TermDictionary> new_terms;
+    const DocumentOrdinal ordinal = segment->size();
     const double inv_word_count = 1.0 / words.size();
-    std::map<std::string_view, double> word_freq;
+    auto document_data = std::make_shared<DocumentData>();
+    document_data->text = std::move(text);
+    std::map<TermId, double> term_freqs;
     for (const std::string_view word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        word_freq[word] = inv_word_count;
+        TermId term_id = (new_terms ? *new_terms : *segment->terms).Find(word);
+        if (term_id == TermDictionary::NO_TERM) {
+            if (!new_terms) {
+                new_terms = std::make_shared<TermDictionary>(*segment->terms);
+            }
+            term_id = new_terms->Intern(word);
+            segment->term_postings.push_back(std::make_shared<const PostingList>());
+        }
+        term_freqs[term_id] += inv_word_count;
+        document_data->freq[word] = inv_word_count;
+    }
+    if (new_terms) {
+        segment->terms = std::move(new_terms);
+    }
+    for (const auto& [term_id, term_freq] : term_freqs) {
+        auto postings = std::make_shared<PostingList>(segment->GetPostings(term_id));
+        postings->Add(ordinal, term_freq);
+        segment->term_postings[term_id] = std::move(postings);
+    }
+
+    segment->AddDocumentIds({ { document_id, ordinal } });
+    segment->ordinal_documents.push_back(std::move(document_data));
+    segment->ordinal_to_document_id.push_back(document_id);
+    segment->ordinal_ratings.push_back(ComputeAverageRating(ratings));
+    segment->ordinal_statuses.push_back(status);
+    segment->is_sealed = segment->size() >= WRITE_BUFFER_SIZE;
+    const bool is_sealed = segment->is_sealed;
+    index->segments.back().segment = std::move(segment);
+    ++index->document_count;
+    ++index->generation;
+    index->document_ids = std::make_shared<DocumentIdList>();
+    UpdateLogTables(*index);
+    const uint64_t log_sequence = LogAddDocument(document_id, document, status, ratings);
+    PublishIndex(std::move(index));
+    if (is_sealed) {
+        RequestMerge();
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, word_freq });
-    document_ids_.insert(document_id);
+    guard.unlock();
+    WaitForOperationLog(log_sequence);
+}
+
+void SearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    AddDocuments(std::execution::seq, documents);
 }
 
 
 int SearchServer::GetDocumentCount() const {
-    return static_cast<int>(documents_.size());
+    return static_cast<int>(GetIndex()->document_count);
+}
+
+void SearchServer::SetMaxResultDocumentCount(size_t max_result_document_count) {
+    max_result_document_count_ = max_result_document_count;
+}
+
+size_t SearchServer::GetMaxResultDocumentCount() const {
+    return max_result_document_count_.load();
+}
+
+void SearchServer::SetResultCacheCapacity(size_t max_entries) {
+    result_cache_.SetCapacity(max_entries);
 }
 
+ResultCache::Stats SearchServer::GetResultCacheStats() const {
+    return result_cache_.GetStats();
+}
 
-std::set<int>::const_iterator SearchServer::begin() {
-    return document_ids_.begin();
+QueryMetrics::Snapshot SearchServer::GetMetrics() const {
+    return query_metrics_.GetSnapshot();
 }
 
-std::set<int>::const_iterator  SearchServer::end() {
-    return document_ids_.end();
+void SearchServer::ResetMetrics() {
+    query_metrics_.Clear();
+}
+
+
+SearchServer::DocumentIdIterator SearchServer::begin() {
+    DocumentIdIterator it;
+    it.index_ = GetIndex();
+    it.document_ids_ = &it.index_->GetDocumentIds();
+    return it;
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    const static std::map<std::string_view, double> empty_map{};
-    if (documents_.count(document_id)) {
-        return documents_.at(document_id).freq;
+SearchServer::DocumentIdIterator SearchServer::end() {
+    return DocumentIdIterator();
+}
+
+SearchServer::WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const static WordFrequencies::Map empty_map{};
+    WordFrequencies word_frequencies;
+    const std::shared_ptr<const Index> index = GetIndex();
+    if (const std::optional<DocumentLocation> location = index->FindDocument(document_id)) {
+        std::shared_ptr<const DocumentData> document_data
+            = index->segments[location->segment].segment->GetDocumentData(location->ordinal);
+        word_frequencies.freqs_ = std::shared_ptr<const WordFrequencies::Map>(document_data, &document_data->freq);
     }
     else {
-        return empty_map;
+        word_frequencies.freqs_ = std::shared_ptr<const WordFrequencies::Map>(std::shared_ptr<const void>(), &empty_map);
     }
+    return word_frequencies;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
-    for (auto [word, rating] : documents_[document_id].freq) {
-        word_to_document_freqs_.at(word).erase(document_id);
+    PROFILE_SCOPE("SearchServer::RemoveDocument");
+    std::unique_lock guard(write_mutex_);
+    auto index = std::make_shared<Index>(*GetIndex());
+    const std::optional<DocumentLocation> location = index->FindDocument(document_id);
+    if (!location) {
+        return;
+    }
+    AddTombstone(index->segments[location->segment], location->ordinal);
+    --index->document_count;
+    ++index->generation;
+    index->document_ids = std::make_shared<DocumentIdList>();
+    UpdateLogTables(*index);
+    const uint64_t log_sequence = LogRemoveDocument(document_id);
+    PublishIndex(std::move(index));
+    RequestMerge();
+    guard.unlock();
+    WaitForOperationLog(log_sequence);
+}
+
+void SearchServer::CompactStorage() {
+    std::lock_guard guard(write_mutex_);
+    const std::shared_ptr<const Index> current_index = GetIndex();
+    auto is_stored_document = [](const IndexSegment& index_segment, size_t i) {
+        const auto& document_data = index_segment.segment->ordinal_documents[i];
+        return document_data && document_data->text.chunk;
+    };
+    auto is_deleted_document = [](const IndexSegment& index_segment, size_t i) {
+        return index_segment.IsDeleted(index_segment.segment->GetMappedDocumentCount() + static_cast<DocumentOrdinal>(i));
+    };
+    std::map<const TextArena::Chunk*, size_t> chunk_live_bytes;
+    for (const IndexSegment& index_segment : current_index->segments) {
+        for (size_t i = 0; i < index_segment.segment->ordinal_documents.size(); ++i) {
+            if (is_stored_document(index_segment, i) && !is_deleted_document(index_segment, i)) {
+                const TextArena::StoredText& text = index_segment.segment->ordinal_documents[i]->text;
+                chunk_live_bytes[text.chunk.get()] += text.text.size();
+            }
+        }
+    }
+
+    std::shared_ptr<Index> index;
+    for (size_t segment_index = 0; segment_index < current_index->segments.size(); ++segment_index) {
+        const IndexSegment& index_segment = current_index->segments[segment_index];
+        std::shared_ptr<Segment> segment;
+        for (size_t i = 0; i < index_segment.segment->ordinal_documents.size(); ++i) {
+            if (!is_stored_document(index_segment, i)) {
+                continue;
+            }
+            const auto& document_data = index_segment.segment->ordinal_documents[i];
+            const TextArena::Chunk* chunk = document_data->text.chunk.get();
+            if (documents_storage.IsActiveChunk(chunk)
+                || chunk_live_bytes[chunk] >= chunk->capacity() * MIN_STORAGE_UTILIZATION) {
+                continue;
+            }
+            if (!segment) {
+                segment = std::make_shared<Segment>(*index_segment.segment);
+            }
+            //       :   
+            //      
+            if (is_deleted_document(index_segment, i)) {
+                segment->ordinal_documents[i] = nullptr;
+                continue;
+            }
+            auto moved_document_data = std::make_shared<DocumentData>();
+            moved_document_data->text = documents_storage.Store(document_data->text.text);
+            const char* old_text = document_data->text.text.data();
+            for (const auto& [word, term_freq] : document_data->freq) {
+                moved_document_data->freq.emplace_hint(moved_document_data->freq.end(),
+                    moved_document_data->text.text.substr(word.data() - old_text, word.size()), term_freq);
+            }
+            segment->ordinal_documents[i] = std::move(moved_document_data);
+        }
+        if (segment) {
+            if (!index) {
+                index = std::make_shared<Index>(*current_index);
+            }
+            index->segments[segment_index].segment = std::move(segment);
+        }
+    }
+    if (index) {
+        PublishIndex(std::move(index));
     }
-    documents_.erase(document_id);
-    document_ids_.erase(find(document_ids_.begin(), document_ids_.end(), document_id));
+}
+
+size_t SearchServer::GetStorageSize() const {
+    return documents_storage.GetAllocatedBytes();
 }
 
 
@@ -80,32 +454,35 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     MakeUniqueVector(query.minus_words);
     MakeUniqueVector(query.plus_words);
 
+    return MatchDocument(query, document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const PreparedQuery& query,
+    int document_id) const {
+    return MatchDocument(query.query_, document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const QueryNew& query,
+    int document_id) const {
+    const std::shared_ptr<const Index> index = GetIndex();
+    const DocumentLocation location = index->GetDocument(document_id);
+    const Segment& segment = *index->segments[location.segment].segment;
+    const DocumentStatus status = segment.ordinal_statuses[location.ordinal];
     std::vector<std::string_view> matched_words;
-    bool galya_cansel = false;
 
     for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.clear();
-            galya_cansel = true;
-            break;
+        if (segment.FindDocumentTerm(word, location.ordinal) != TermDictionary::NO_TERM) {
+            return { matched_words, status };
         }
     }
 
-    if (!galya_cansel) {
-        for (const std::string_view word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            if (word_to_document_freqs_.at(word).count(document_id)) {
-                matched_words.push_back(word);
-            }
+    for (const std::string_view word : query.plus_words) {
+        const TermId term_id = segment.FindDocumentTerm(word, location.ordinal);
+        if (term_id != TermDictionary::NO_TERM) {
+            matched_words.push_back(segment.terms->GetTerm(term_id));
         }
     }
-    return { matched_words, documents_.at(document_id).status };
+    return { matched_words, status };
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy& policy, const std::string_view raw_query,
@@ -115,25 +492,32 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy& policy, const std::string_view raw_query,
     int document_id) const {
+    const std::shared_ptr<const Index> index = GetIndex();
     QueryNew query = SearchServer::ParseQuery(raw_query);
 
+    const DocumentLocation location = index->GetDocument(document_id);
+    const Segment& segment = *index->segments[location.segment].segment;
+    const DocumentStatus status = segment.ordinal_statuses[location.ordinal];
     std::vector<std::string_view> matched_words;
 
-    bool galya_cansel = std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), [&](const auto& word) {
-        return word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id);
+    bool galya_cansel = std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), [&](const std::string_view word) {
+        return segment.FindDocumentTerm(word, location.ordinal) != TermDictionary::NO_TERM;
         });
 
     if (!galya_cansel) {
-        matched_words.resize(query.plus_words.size());
-        auto last = std::copy_if(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+        std::vector<std::string_view> plus_words(query.plus_words.size());
+        auto last = std::copy_if(policy, query.plus_words.begin(), query.plus_words.end(), plus_words.begin(),
             [&](const std::string_view word) {
-                return word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id);
+                return segment.FindDocumentTerm(word, location.ordinal) != TermDictionary::NO_TERM;
+            });
+        std::sort(policy, plus_words.begin(), last);
+        last = std::unique(policy, plus_words.begin(), last);
+        matched_words.reserve(distance(plus_words.begin(), last));
+        std::transform(plus_words.begin(), last, std::back_inserter(matched_words), [&segment](const std::string_view word) {
+            return segment.terms->GetTerm(segment.terms->Find(word));
             });
-        std::sort(policy, matched_words.begin(), last);
-        auto last2 = std::unique(policy, matched_words.begin(), last);
-        matched_words.resize(distance(matched_words.begin(), last2));
     }
-    return { matched_words, documents_.at(document_id).status };
+    return { matched_words, status };
 }
 
 bool SearchServer::IsStopWord(const std::string_view word) const {
@@ -141,31 +525,30 @@ bool SearchServer::IsStopWord(const std::string_view word) const {
 }
 
 bool SearchServer::IsValidWord(const std::string_view word) {
-    return std::none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
-        });
+    return FindControlChar(word) == std::string_view::npos;
 }
 
 bool SearchServer::IsInvalidQuery(const std::string& text) {
 
-    bool double_minus = std::regex_match(text, std::regex("(--)(.*)"));
+    bool double_minus = text.starts_with("--"s);
     bool last_char_is_minus = (!text.empty() && text[text.size() - 1] == '-');
 
     return double_minus || last_char_is_minus;
 
 }
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string& text) const {
-    std::vector<std::string_view> words;
-    for (const std::string_view word : SplitIntoWords(std::string_view(text))) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
-        }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+void SearchServer::SplitIntoWordsNoStop(const std::string_view text, std::vector<std::string_view>& words) const {
+    const size_t first_control = SplitIntoWords(text, words);
+    if (first_control != std::string_view::npos) {
+        //    ,    - 
+        const std::string_view word = *std::find_if(words.begin(), words.end(), [&](const std::string_view word) {
+            return word.data() + word.size() > text.data() + first_control;
+            });
+        throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
     }
-    return words;
+    words.erase(std::remove_if(words.begin(), words.end(), [this](const std::string_view word) {
+        return IsStopWord(word);
+        }), words.end());
 }
 
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
@@ -179,7 +562,97 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
+std::shared_ptr<SearchServer::Segment> SearchServer::MapIndex(std::shared_ptr<const IndexFile> index_file) {
+    auto mapped = std::make_shared<MappedIndex>();
+    mapped->terms = std::make_shared<const TermDictionary>(
+        index_file->GetSection<char>(IndexSection::TERM_BYTES),
+        index_file->GetSection<uint64_t>(IndexSection::TERM_OFFSETS),
+        index_file->GetSection<size_t>(IndexSection::TERM_HASHES),
+        index_file->GetSection<TermId>(IndexSection::TERM_SLOTS));
+
+    const size_t term_count = mapped->terms->size();
+    const auto posting_offsets = index_file->GetSection<uint64_t>(IndexSection::POSTING_OFFSETS);
+    const auto posting_ordinals = index_file->GetSection<DocumentOrdinal>(IndexSection::POSTING_ORDINALS);
+    const auto posting_term_freqs = index_file->GetSection<double>(IndexSection::POSTING_TERM_FREQS);
+    const auto posting_max_term_freqs = index_file->GetSection<double>(IndexSection::POSTING_MAX_TERM_FREQS);
+    if (posting_offsets.size() != term_count + 1 || posting_max_term_freqs.size() != term_count
+        || posting_term_freqs.size() != posting_ordinals.size()) {
+        throw std::invalid_argument("Invalid index file postings"s);
+    }
+    auto packed_postings = std::make_shared<PackedPostings>();
+    packed_postings->lists.reserve(term_count);
+    for (TermId term_id = 0; term_id < term_count; ++term_id) {
+        const uint64_t begin = posting_offsets[term_id];
+        const uint64_t end = posting_offsets[term_id + 1];
+        if (begin > end || end > posting_ordinals.size()) {
+            throw std::invalid_argument("Invalid index file postings"s);
+        }
+        packed_postings->lists.emplace_back(posting_ordinals.subspan(begin, end - begin),
+            posting_term_freqs.subspan(begin, end - begin), posting_max_term_freqs[term_id]);
+    }
+    packed_postings->file = index_file;
+
+    mapped->text_offsets = index_file->GetSection<uint64_t>(IndexSection::DOCUMENT_TEXT_OFFSETS);
+    mapped->texts = index_file->GetSection<char>(IndexSection::DOCUMENT_TEXTS);
+    mapped->term_offsets = index_file->GetSection<uint64_t>(IndexSection::DOCUMENT_TERM_OFFSETS);
+    mapped->document_terms = index_file->GetSection<TermId>(IndexSection::DOCUMENT_TERMS);
+    mapped->word_freqs = index_file->GetSection<double>(IndexSection::DOCUMENT_WORD_FREQS);
+
+    auto segment = std::make_shared<Segment>();
+    segment->terms = mapped->terms;
+    segment->term_postings.resize(term_count);
+    segment->packed_postings = std::move(packed_postings);
+    segment->document_ids = MappedColumn<int>(index_file->GetSection<int>(IndexSection::DOCUMENT_IDS));
+    segment->document_ordinals = MappedColumn<DocumentOrdinal>(index_file->GetSection<DocumentOrdinal>(IndexSection::DOCUMENT_ORDINALS));
+    segment->ordinal_to_document_id = MappedColumn<int>(index_file->GetSection<int>(IndexSection::ORDINAL_DOCUMENT_IDS));
+    segment->ordinal_ratings = MappedColumn<int>(index_file->GetSection<int>(IndexSection::ORDINAL_RATINGS));
+    segment->ordinal_statuses = MappedColumn<DocumentStatus>(index_file->GetSection<DocumentStatus>(IndexSection::ORDINAL_STATUSES));
+    segment->is_sealed = true;
+
+    const size_t ordinal_count = mapped->word_freqs.size();
+    if (segment->document_ids.size() != segment->document_ordinals.size()
+        || segment->ordinal_to_document_id.size() != ordinal_count
+        || segment->ordinal_ratings.size() != ordinal_count
+        || segment->ordinal_statuses.size() != ordinal_count
+        || mapped->text_offsets.size() != ordinal_count + 1 || mapped->text_offsets.back() > mapped->texts.size()
+        || mapped->term_offsets.size() != ordinal_count + 1 || mapped->term_offsets.back() > mapped->document_terms.size()) {
+        throw std::invalid_argument("Invalid index file documents"s);
+    }
+    mapped->file = std::move(index_file);
+    segment->mapped = std::move(mapped);
+    return segment;
+}
+
+void SearchServer::CheckNewDocumentIds(const Index& index, std::vector<int> document_ids) {
+    std::sort(document_ids.begin(), document_ids.end());
+    const bool is_invalid = (!document_ids.empty() && document_ids.front() < 0)
+        || std::adjacent_find(document_ids.begin(), document_ids.end()) != document_ids.end()
+        || std::any_of(document_ids.begin(), document_ids.end(), [&index](int document_id) {
+            return index.FindDocument(document_id).has_value();
+            });
+    if (is_invalid) {
+        throw std::invalid_argument("Invalid document_id"s);
+    }
+}
+
+void SearchServer::CheckDocumentText(const std::string_view text) {
+    const size_t first_control = FindControlChar(text);
+    if (first_control == std::string_view::npos) {
+        return;
+    }
+    const size_t word_begin = text.rfind(' ', first_control) + 1;
+    const size_t word_end = std::min(text.find(' ', first_control), text.size());
+    throw std::invalid_argument("Word "s + std::string(text.substr(word_begin, word_end - word_begin)) + " is invalid"s);
+}
+
+bool SearchServer::IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < INACCURACY) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text, bool is_valid) const {
     if (text.empty()) {
         throw std::invalid_argument("Query word is empty"s);
     }
@@ -189,7 +662,7 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
         is_minus = true;
         word = word.substr(1);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+    if (word.empty() || word[0] == '-' || !is_valid) {
         throw std::invalid_argument("Query word "s + std::string(text) + " is invalid");
     }
 
@@ -198,22 +671,786 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
 
 SearchServer::QueryNew SearchServer::ParseQuery(const std::string_view text) const {
     QueryNew result;
-    for (const auto word : SplitIntoWords(text)) {
-        const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
+    std::vector<std::string_view> words;
+    ParseQuery(text, words, result);
+    return result;
+}
+
+void SearchServer::ParseQuery(const std::string_view text, std::vector<std::string_view>& words, QueryNew& result) const {
+    result.plus_words.clear();
+    result.minus_words.clear();
+    const size_t first_control = SplitIntoWords(text, words);
+    const char* const control = first_control == std::string_view::npos ? nullptr : text.data() + first_control;
+    for (const auto word : words) {
+        //      :    
+        const bool is_valid = control == nullptr || control < word.data() || control >= word.data() + word.size();
+        const QueryWord query_word = ParseQueryWord(word, is_valid);
+        if (query_word.is_stop) {
+            continue;
+        }
+        if (query_word.is_minus) {
+            result.minus_words.push_back(query_word.data);
+        }
+        else {
+            result.plus_words.push_back(query_word.data);
+        }
+    }
+}
+
+
+std::shared_ptr<const SearchServer::Index> SearchServer::GetIndex() const {
+    return index_.load();
+}
+
+void SearchServer::PublishIndex(std::shared_ptr<Index> index) {
+    index_.store(std::move(index));
+}
+
+void SearchServer::UpdateLogTables(Index& index) {
+    index.log_document_count = std::log(static_cast<double>(index.document_count));
+    const std::vector<double>& log_document_freqs = *index.log_document_freqs;
+    if (index.document_count < log_document_freqs.size()) {
+        return;
+    }
+    auto grown_log_document_freqs = std::make_shared<std::vector<double>>(log_document_freqs);
+    const size_t size = std::max({ log_document_freqs.size() * 2, index.document_count + 1, MIN_LOG_TABLE_SIZE });
+    grown_log_document_freqs->reserve(size);
+    for (size_t document_freq = log_document_freqs.size(); document_freq < size; ++document_freq) {
+        grown_log_document_freqs->push_back(std::log(static_cast<double>(document_freq)));
+    }
+    index.log_document_freqs = std::move(grown_log_document_freqs);
+}
+
+SearchServer::TermCursor::TermCursor(const PostingList& postings, PostingList::BlockBuffer& buffer,
+    double inverse_document_freq)
+    : postings(&postings)
+    , buffer(&buffer)
+    , block_index(0)
+    , block_count(postings.GetBlockCount())
+    , pos(0)
+    , inverse_document_freq(inverse_document_freq)
+    , max_score(postings.GetMaxTermFreq() * inverse_document_freq)
+{
+    LoadBlock(0);
+}
+
+bool SearchServer::TermCursor::AtEnd() const {
+    return block_index == block_count;
+}
+
+DocumentOrdinal SearchServer::TermCursor::Current() const {
+    return block.ordinals[pos];
+}
+
+double SearchServer::TermCursor::GetTermFreq() const {
+    return block.term_freqs[pos];
+}
+
+void SearchServer::TermCursor::Next() {
+    if (++pos == block.ordinals.size()) {
+        LoadBlock(block_index + 1);
+    }
+}
+
+bool SearchServer::TermCursor::SeekTo(DocumentOrdinal ordinal) {
+    if (AtEnd()) {
+        return false;
+    }
+    if (postings->GetBlockLastOrdinal(block_index) < ordinal) {
+        LoadBlock(postings->FindBlock(ordinal, block_index + 1));
+        if (AtEnd()) {
+            return false;
+        }
+    }
+    pos = std::lower_bound(block.ordinals.begin() + pos, block.ordinals.end(), ordinal) - block.ordinals.begin();
+    return block.ordinals[pos] == ordinal;
+}
+
+void SearchServer::TermCursor::LoadBlock(size_t index) {
+    block_index = index;
+    pos = 0;
+    block = block_index < block_count ? postings->GetBlock(block_index, *buffer) : PostingList::Block{};
+}
+
+PostingList::BlockBuffer& SearchServer::QueryContext::GetBlockBuffer(size_t index) {
+    while (block_buffers_.size() <= index) {
+        block_buffers_.push_back(std::make_unique<PostingList::BlockBuffer>());
+    }
+    return *block_buffers_[index];
+}
+
+void SearchServer::ComputeInverseDocumentFreqs(const Index& index, const std::vector<std::string_view>& words,
+    std::vector<double>& inverse_document_freqs) {
+    inverse_document_freqs.resize(words.size());
+    const std::vector<double>& log_document_freqs = *index.log_document_freqs;
+    std::transform(words.begin(), words.end(), inverse_document_freqs.begin(), [&](const std::string_view word) {
+        size_t document_freq = 0;
+        for (const IndexSegment& index_segment : index.segments) {
+            const TermId term_id = index_segment.segment->terms->Find(word);
+            if (term_id != TermDictionary::NO_TERM) {
+                document_freq += index_segment.GetDocumentFreq(term_id);
             }
-            else {
-                result.plus_words.push_back(query_word.data);
+        }
+        return index.log_document_count - log_document_freqs[document_freq];
+        });
+}
+
+void SearchServer::ResolveQuery(const IndexSegment& index_segment, const QueryNew& query,
+    const std::vector<double>& inverse_document_freqs, SegmentQuery& segment_query) {
+    const Segment& segment = *index_segment.segment;
+    segment_query.plus_postings.clear();
+    segment_query.inverse_document_freqs.clear();
+    segment_query.minus_postings.clear();
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        const TermId term_id = segment.terms->Find(query.plus_words[i]);
+        if (term_id != TermDictionary::NO_TERM && index_segment.GetDocumentFreq(term_id) > 0) {
+            segment_query.plus_postings.push_back(&segment.GetPostings(term_id));
+            segment_query.inverse_document_freqs.push_back(inverse_document_freqs[i]);
+        }
+    }
+    for (const std::string_view word : query.minus_words) {
+        const TermId term_id = segment.terms->Find(word);
+        if (term_id != TermDictionary::NO_TERM && index_segment.GetDocumentFreq(term_id) > 0) {
+            segment_query.minus_postings.push_back(&segment.GetPostings(term_id));
+        }
+    }
+
+    //    ,      idf,  
+    std::vector<const PostingList*>& plus_postings = segment_query.plus_postings;
+    for (size_t i = 1; i < plus_postings.size(); ++i) {
+        for (size_t j = i; j > 0 && plus_postings[j]->size() < plus_postings[j - 1]->size(); --j) {
+            std::swap(plus_postings[j], plus_postings[j - 1]);
+            std::swap(segment_query.inverse_document_freqs[j], segment_query.inverse_document_freqs[j - 1]);
+        }
+    }
+    std::sort(segment_query.minus_postings.begin(), segment_query.minus_postings.end(),
+        [](const PostingList* lhs, const PostingList* rhs) {
+            return lhs->size() > rhs->size();
+        });
+}
+
+void SearchServer::ResolveQuery(const Index& index, const QueryNew& query, std::vector<double>& inverse_document_freqs,
+    std::vector<SegmentQuery>& segment_queries) {
+    ComputeInverseDocumentFreqs(index, query.plus_words, inverse_document_freqs);
+    segment_queries.resize(index.segments.size());
+    for (size_t i = 0; i < index.segments.size(); ++i) {
+        ResolveQuery(index.segments[i], query, inverse_document_freqs, segment_queries[i]);
+    }
+}
+
+void SearchServer::MakeResultCacheKey(const QueryNew& query, DocumentStatus status, size_t max_result_document_count,
+    std::string& key) {
+    key.clear();
+    key += std::to_string(static_cast<int>(status));
+    key += ' ';
+    key += std::to_string(max_result_document_count);
+    for (const std::string_view word : query.plus_words) {
+        key += " +";
+        key += word;
+    }
+    for (const std::string_view word : query.minus_words) {
+        key += " -";
+        key += word;
+    }
+}
+
+size_t SearchServer::PreparedQuery::GetPostingCount() const {
+    size_t posting_count = 0;
+    for (const SegmentQuery& segment_query : segment_queries_) {
+        for (const PostingList* postings : segment_query.plus_postings) {
+            posting_count += postings->size();
+        }
+    }
+    return posting_count;
+}
+
+std::vector<SearchServer::QueryPart> SearchServer::SplitQuery(const PreparedQuery& query,
+    size_t max_part_posting_count) const {
+    std::vector<QueryPart> parts;
+    std::shared_ptr<const Index> index = query.index_.lock();
+    if (index != GetIndex()) {
+        return parts;
+    }
+    max_part_posting_count = std::max<size_t>(1, max_part_posting_count);
+    for (size_t i = 0; i < index->segments.size(); ++i) {
+        size_t posting_count = 0;
+        for (const PostingList* postings : query.segment_queries_[i].plus_postings) {
+            posting_count += postings->size();
+        }
+        if (posting_count == 0) {
+            continue;
+        }
+        //       
+        const size_t ordinal_count = index->segments[i].segment->size();
+        const size_t part_count = std::min(ordinal_count, (posting_count + max_part_posting_count - 1) / max_part_posting_count);
+        for (size_t part = 0; part < part_count; ++part) {
+            QueryPart& query_part = parts.emplace_back();
+            query_part.index_ = index;
+            query_part.segment_ = i;
+            query_part.first_ordinal_ = static_cast<DocumentOrdinal>(ordinal_count * part / part_count);
+            query_part.last_ordinal_ = static_cast<DocumentOrdinal>(ordinal_count * (part + 1) / part_count);
+        }
+    }
+    return parts;
+}
+
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const PreparedQuery& query,
+    const QueryPart& part) const {
+    if (query.index_.lock() != part.index_) {
+        throw std::invalid_argument("Query part belongs to another query"s);
+    }
+    std::vector<Document>& top_documents = context.documents_;
+    top_documents.clear();
+    const size_t max_result_document_count = GetMaxResultDocumentCount();
+    if (max_result_document_count == 0) {
+        return top_documents;
+    }
+    CollectTopDocumentsPruned(part.index_->segments[part.segment_], query.segment_queries_[part.segment_], context,
+        [](int, DocumentStatus document_status, int) {
+            return document_status == DocumentStatus::ACTUAL;
+        },
+        max_result_document_count, part.first_ordinal_, part.last_ordinal_);
+    std::sort_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+    return top_documents;
+}
+
+void SearchServer::MergeTopDocuments(std::vector<Document>& documents) const {
+    std::stable_sort(documents.begin(), documents.end(), IsMoreRelevant);
+    documents.resize(std::min(documents.size(), GetMaxResultDocumentCount()));
+}
+
+SearchServer::PreparedQuery SearchServer::PrepareQuery(const std::string_view raw_query) const {
+    PreparedQuery prepared;
+    prepared.text_ = std::make_shared<const std::string>(raw_query);
+    std::vector<std::string_view> words;
+    ParseQuery(*prepared.text_, words, prepared.query_);
+    MakeUniqueVector(prepared.query_.minus_words);
+    MakeUniqueVector(prepared.query_.plus_words);
+
+    const std::shared_ptr<const Index> index = GetIndex();
+    std::vector<double> inverse_document_freqs;
+    ResolveQuery(*index, prepared.query_, inverse_document_freqs, prepared.segment_queries_);
+    prepared.index_ = index;
+    return prepared;
+}
+
+DocumentOrdinal SearchServer::Segment::size() const {
+    return static_cast<DocumentOrdinal>(ordinal_to_document_id.size());
+}
+
+const PostingList& SearchServer::Segment::GetPostings(TermId term_id) const {
+    const std::shared_ptr<const PostingList>& postings = term_postings[term_id];
+    return postings ? *postings : packed_postings->lists[term_id];
+}
+
+SearchServer::TermId SearchServer::Segment::FindDocumentTerm(std::string_view word, DocumentOrdinal ordinal) const {
+    const TermId term_id = terms->Find(word);
+    return term_id != TermDictionary::NO_TERM && GetPostings(term_id).Contains(ordinal) ? term_id : TermDictionary::NO_TERM;
+}
+
+DocumentOrdinal SearchServer::Segment::GetMappedDocumentCount() const {
+    return mapped ? static_cast<DocumentOrdinal>(mapped->word_freqs.size()) : 0;
+}
+
+const SearchServer::DocumentData* SearchServer::Segment::FindStoredDocument(DocumentOrdinal ordinal) const {
+    const DocumentOrdinal mapped_document_count = GetMappedDocumentCount();
+    return ordinal < mapped_document_count ? nullptr : ordinal_documents[ordinal - mapped_document_count].get();
+}
+
+std::shared_ptr<const SearchServer::DocumentData> SearchServer::Segment::GetDocumentData(DocumentOrdinal ordinal) const {
+    const DocumentOrdinal mapped_document_count = GetMappedDocumentCount();
+    return ordinal < mapped_document_count ? mapped->GetDocumentData(ordinal) : ordinal_documents[ordinal - mapped_document_count];
+}
+
+std::vector<SearchServer::TermId> SearchServer::Segment::GetDocumentTerms(DocumentOrdinal ordinal) const {
+    if (ordinal < GetMappedDocumentCount()) {
+        const std::span<const TermId> document_terms = mapped->GetTerms(ordinal);
+        return std::vector<TermId>(document_terms.begin(), document_terms.end());
+    }
+    std::vector<TermId> document_terms;
+    for (const auto& [word, term_freq] : GetDocumentData(ordinal)->freq) {
+        document_terms.push_back(terms->Find(word));
+    }
+    std::sort(document_terms.begin(), document_terms.end());
+    return document_terms;
+}
+
+std::string_view SearchServer::MappedIndex::GetText(DocumentOrdinal ordinal) const {
+    return std::string_view(texts.data() + text_offsets[ordinal], text_offsets[ordinal + 1] - text_offsets[ordinal]);
+}
+
+std::span<const SearchServer::TermId> SearchServer::MappedIndex::GetTerms(DocumentOrdinal ordinal) const {
+    return document_terms.subspan(term_offsets[ordinal], term_offsets[ordinal + 1] - term_offsets[ordinal]);
+}
+
+std::shared_ptr<const SearchServer::DocumentData> SearchServer::MappedIndex::GetDocumentData(DocumentOrdinal ordinal) const {
+    std::lock_guard guard(documents_mutex);
+    std::shared_ptr<const DocumentData>& document_data = documents[ordinal];
+    if (!document_data) {
+        auto decoded_document_data = std::make_shared<DocumentData>();
+        for (const TermId term_id : GetTerms(ordinal)) {
+            decoded_document_data->freq.emplace(terms->GetTerm(term_id), word_freqs[ordinal]);
+        }
+        decoded_document_data->text.text = GetText(ordinal);
+        document_data = std::move(decoded_document_data);
+    }
+    return document_data;
+}
+
+void SearchServer::Segment::AddDocumentIds(const std::vector<std::pair<int, DocumentOrdinal>>& sorted_ordinals) {
+    if (sorted_ordinals.size() == 1) {
+        std::vector<int>& ids = document_ids.GetMutable();
+        std::vector<DocumentOrdinal>& ordinals = document_ordinals.GetMutable();
+        const auto id_it = std::upper_bound(ids.begin(), ids.end(), sorted_ordinals[0].first);
+        ordinals.insert(ordinals.begin() + (id_it - ids.begin()), sorted_ordinals[0].second);
+        ids.insert(id_it, sorted_ordinals[0].first);
+        return;
+    }
+    std::vector<int> merged_ids;
+    std::vector<DocumentOrdinal> merged_ordinals;
+    merged_ids.reserve(document_ids.size() + sorted_ordinals.size());
+    merged_ordinals.reserve(document_ids.size() + sorted_ordinals.size());
+    size_t i = 0;
+    for (const auto& [document_id, ordinal] : sorted_ordinals) {
+        for (; i < document_ids.size() && document_ids[i] <= document_id; ++i) {
+            merged_ids.push_back(document_ids[i]);
+            merged_ordinals.push_back(document_ordinals[i]);
+        }
+        merged_ids.push_back(document_id);
+        merged_ordinals.push_back(ordinal);
+    }
+    merged_ids.insert(merged_ids.end(), document_ids.begin() + i, document_ids.end());
+    merged_ordinals.insert(merged_ordinals.end(), document_ordinals.begin() + i, document_ordinals.end());
+    document_ids = MappedColumn<int>(std::move(merged_ids));
+    document_ordinals = MappedColumn<DocumentOrdinal>(std::move(merged_ordinals));
+}
+
+bool SearchServer::Tombstones::IsDeleted(DocumentOrdinal ordinal) const {
+    return ordinal / 64 < deleted.size() && (deleted[ordinal / 64] >> (ordinal % 64) & 1);
+}
+
+DocumentOrdinal SearchServer::Tombstones::GetTermCount(TermId term_id) const {
+    const auto it = std::lower_bound(term_counts.begin(), term_counts.end(), std::pair{ term_id, DocumentOrdinal{ 0 } });
+    return it != term_counts.end() && it->first == term_id ? it->second : 0;
+}
+
+bool SearchServer::IndexSegment::IsDeleted(DocumentOrdinal ordinal) const {
+    return tombstones && tombstones->IsDeleted(ordinal);
+}
+
+std::optional<DocumentOrdinal> SearchServer::IndexSegment::FindOrdinal(int document_id) const {
+    const MappedColumn<int>& document_ids = segment->document_ids;
+    const auto [first, last] = std::equal_range(document_ids.begin(), document_ids.end(), document_id);
+    for (auto id_it = first; id_it != last; ++id_it) {
+        const DocumentOrdinal ordinal = segment->document_ordinals[id_it - document_ids.begin()];
+        if (!IsDeleted(ordinal)) {
+            return ordinal;
+        }
+    }
+    return std::nullopt;
+}
+
+size_t SearchServer::IndexSegment::GetDocumentCount() const {
+    return segment->document_ids.size() - (tombstones ? tombstones->count : 0);
+}
+
+size_t SearchServer::IndexSegment::GetDocumentFreq(TermId term_id) const {
+    return segment->GetPostings(term_id).size() - (tombstones ? tombstones->GetTermCount(term_id) : 0);
+}
+
+std::optional<SearchServer::DocumentLocation> SearchServer::Index::FindDocument(int document_id) const {
+    //      ,     
+    for (size_t i = segments.size(); i-- > 0;) {
+        if (const std::optional<DocumentOrdinal> ordinal = segments[i].FindOrdinal(document_id)) {
+            return DocumentLocation{ i, *ordinal };
+        }
+    }
+    return std::nullopt;
+}
+
+SearchServer::DocumentLocation SearchServer::Index::GetDocument(int document_id) const {
+    const std::optional<DocumentLocation> location = FindDocument(document_id);
+    if (!location) {
+        throw std::out_of_range("Document "s + std::to_string(document_id) + " not found"s);
+    }
+    return *location;
+}
+
+const std::vector<int>& SearchServer::Index::GetDocumentIds() const {
+    std::call_once(document_ids->once, [this]() {
+        std::vector<int>& ids = document_ids->ids;
+        ids.reserve(document_count);
+        for (const IndexSegment& index_segment : segments) {
+            const Segment& segment = *index_segment.segment;
+            for (size_t i = 0; i < segment.document_ids.size(); ++i) {
+                if (!index_segment.IsDeleted(segment.document_ordinals[i])) {
+                    ids.push_back(segment.document_ids[i]);
+                }
             }
         }
+        std::sort(ids.begin(), ids.end());
+        });
+    return document_ids->ids;
+}
+
+SearchServer::DocumentIdIterator::reference SearchServer::DocumentIdIterator::operator*() const {
+    return (*document_ids_)[position_];
+}
+
+SearchServer::DocumentIdIterator& SearchServer::DocumentIdIterator::operator++() {
+    ++position_;
+    return *this;
+}
+
+SearchServer::DocumentIdIterator SearchServer::DocumentIdIterator::operator++(int) {
+    DocumentIdIterator old = *this;
+    ++position_;
+    return old;
+}
+
+bool SearchServer::DocumentIdIterator::operator==(const DocumentIdIterator& other) const {
+    if (IsEnd() || other.IsEnd()) {
+        return IsEnd() == other.IsEnd();
     }
+    return document_ids_ == other.document_ids_ && position_ == other.position_;
+}
 
-    return result;
+bool SearchServer::DocumentIdIterator::IsEnd() const {
+    return !document_ids_ || position_ == document_ids_->size();
+}
+
+SearchServer::WordFrequencies::const_iterator SearchServer::WordFrequencies::begin() const {
+    return freqs_->begin();
+}
+
+SearchServer::WordFrequencies::const_iterator SearchServer::WordFrequencies::end() const {
+    return freqs_->end();
+}
+
+size_t SearchServer::WordFrequencies::size() const {
+    return freqs_->size();
 }
 
+bool SearchServer::WordFrequencies::empty() const {
+    return freqs_->empty();
+}
+
+size_t SearchServer::WordFrequencies::count(std::string_view word) const {
+    return freqs_->count(word);
+}
+
+double SearchServer::WordFrequencies::at(std::string_view word) const {
+    return freqs_->at(word);
+}
+
+const SearchServer::WordFrequencies::Map& SearchServer::WordFrequencies::Get() const {
+    return *freqs_;
+}
+
+bool SearchServer::WordFrequencies::operator==(const WordFrequencies& other) const {
+    return *freqs_ == *other.freqs_;
+}
+
+SearchServer::PostingsPacker::PostingsPacker(const std::vector<size_t>& list_sizes)
+    : max_term_freqs_(list_sizes.size())
+{
+    offsets_.reserve(list_sizes.size() + 1);
+    offsets_.push_back(0);
+    for (const size_t list_size : list_sizes) {
+        offsets_.push_back(offsets_.back() + list_size);
+    }
+    ends_.assign(offsets_.begin(), offsets_.end() - 1);
+    ordinals_.resize(offsets_.back());
+    term_freqs_.resize(offsets_.back());
+}
+
+void SearchServer::PostingsPacker::Add(TermId term_id, DocumentOrdinal ordinal, double term_freq) {
+    const size_t pos = ends_[term_id]++;
+    ordinals_[pos] = ordinal;
+    term_freqs_[pos] = term_freq;
+    max_term_freqs_[term_id] = std::max(max_term_freqs_[term_id], term_freq);
+}
+
+std::shared_ptr<const SearchServer::PackedPostings> SearchServer::PostingsPacker::Finish() {
+    auto packed = std::make_shared<PackedPostings>();
+    packed->term_freq_table = term_freqs_;
+    std::sort(packed->term_freq_table.begin(), packed->term_freq_table.end());
+    packed->term_freq_table.erase(std::unique(packed->term_freq_table.begin(), packed->term_freq_table.end()),
+        packed->term_freq_table.end());
+
+    std::vector<uint32_t> term_freq_codes(term_freqs_.size());
+    std::transform(term_freqs_.begin(), term_freqs_.end(), term_freq_codes.begin(), [&packed](double term_freq) {
+        return static_cast<uint32_t>(std::lower_bound(packed->term_freq_table.begin(), packed->term_freq_table.end(), term_freq)
+            - packed->term_freq_table.begin());
+        });
+
+    const std::span<const DocumentOrdinal> ordinals(ordinals_);
+    const std::span<const uint32_t> codes(term_freq_codes);
+    std::vector<size_t> first_blocks;
+    first_blocks.reserve(max_term_freqs_.size() + 1);
+    for (size_t i = 0; i < max_term_freqs_.size(); ++i) {
+        first_blocks.push_back(packed->blocks.size());
+        PostingList::EncodeBlocks(ordinals.subspan(offsets_[i], ends_[i] - offsets_[i]),
+            codes.subspan(offsets_[i], ends_[i] - offsets_[i]), packed->block_data, packed->blocks);
+    }
+    first_blocks.push_back(packed->blocks.size());
+    packed->block_data.resize(packed->block_data.size() + PostingList::BLOCK_PADDING);
+    packed->block_data.shrink_to_fit();
+    packed->blocks.shrink_to_fit();
+
+    const std::span<const PostingBlockHeader> blocks(packed->blocks);
+    packed->lists.reserve(max_term_freqs_.size());
+    for (size_t i = 0; i < max_term_freqs_.size(); ++i) {
+        packed->lists.emplace_back(blocks.subspan(first_blocks[i], first_blocks[i + 1] - first_blocks[i]),
+            packed->block_data.data(), packed->term_freq_table.data(), ends_[i] - offsets_[i], max_term_freqs_[i]);
+    }
+    return packed;
+}
+
+std::shared_ptr<SearchServer::Segment> SearchServer::MakeSegment() const {
+    auto segment = std::make_shared<Segment>();
+    segment->terms = std::make_shared<const TermDictionary>(term_pool_);
+    return segment;
+}
+
+void SearchServer::SealWriteBuffer(Index& index) {
+    if (!index.segments.empty() && !index.segments.back().segment->is_sealed) {
+        auto segment = std::make_shared<Segment>(*index.segments.back().segment);
+        segment->is_sealed = true;
+        index.segments.back().segment = std::move(segment);
+    }
+}
+
+void SearchServer::AddTombstone(IndexSegment& index_segment, DocumentOrdinal ordinal) {
+    auto tombstones = std::make_shared<Tombstones>();
+    if (index_segment.tombstones) {
+        tombstones->deleted = index_segment.tombstones->deleted;
+        tombstones->count = index_segment.tombstones->count;
+    }
+    if (tombstones->deleted.size() <= ordinal / 64) {
+        tombstones->deleted.resize(ordinal / 64 + 1);
+    }
+    tombstones->deleted[ordinal / 64] |= uint64_t{ 1 } << (ordinal % 64);
+    ++tombstones->count;
+
+    const std::vector<std::pair<TermId, DocumentOrdinal>> empty_term_counts;
+    const auto& term_counts = index_segment.tombstones ? index_segment.tombstones->term_counts : empty_term_counts;
+    auto it = term_counts.begin();
+    for (const TermId term_id : index_segment.segment->GetDocumentTerms(ordinal)) {
+        for (; it != term_counts.end() && it->first < term_id; ++it) {
+            tombstones->term_counts.push_back(*it);
+        }
+        if (it != term_counts.end() && it->first == term_id) {
+            tombstones->term_counts.emplace_back(term_id, it->second + 1);
+            ++it;
+        }
+        else {
+            tombstones->term_counts.emplace_back(term_id, 1);
+        }
+    }
+    tombstones->term_counts.insert(tombstones->term_counts.end(), it, term_counts.end());
+    index_segment.tombstones = std::move(tombstones);
+}
+
+std::shared_ptr<SearchServer::Segment> SearchServer::MergeSegments(std::span<const IndexSegment> sources,
+    std::vector<std::vector<DocumentOrdinal>>& ordinal_maps) const {
+    std::shared_ptr<Segment> merged = MakeSegment();
+    auto terms = std::make_shared<TermDictionary>(term_pool_);
+    std::vector<std::vector<TermId>> term_maps(sources.size());
+    std::vector<size_t> term_sizes;
+    std::vector<std::pair<int, DocumentOrdinal>> new_ordinals;
+    ordinal_maps.assign(sources.size(), {});
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const IndexSegment& source = sources[i];
+        const Segment& segment = *source.segment;
+        std::vector<DocumentOrdinal>& ordinal_map = ordinal_maps[i];
+        ordinal_map.assign(segment.size(), NO_ORDINAL);
+        for (const DocumentOrdinal ordinal : segment.document_ordinals) {
+            if (!source.IsDeleted(ordinal)) {
+                ordinal_map[ordinal] = 0;
+            }
+        }
+        for (DocumentOrdinal ordinal = 0; ordinal < segment.size(); ++ordinal) {
+            if (ordinal_map[ordinal] == NO_ORDINAL) {
+                continue;
+            }
+            ordinal_map[ordinal] = merged->size();
+            new_ordinals.emplace_back(segment.ordinal_to_document_id[ordinal], ordinal_map[ordinal]);
+            merged->ordinal_documents.push_back(segment.GetDocumentData(ordinal));
+            merged->ordinal_to_document_id.push_back(segment.ordinal_to_document_id[ordinal]);
+            merged->ordinal_ratings.push_back(segment.ordinal_ratings[ordinal]);
+            merged->ordinal_statuses.push_back(segment.ordinal_statuses[ordinal]);
+        }
+
+        std::vector<TermId>& term_map = term_maps[i];
+        term_map.assign(segment.terms->size(), TermDictionary::NO_TERM);
+        for (TermId term_id = 0; term_id < segment.terms->size(); ++term_id) {
+            const size_t document_freq = source.GetDocumentFreq(term_id);
+            if (document_freq == 0) {
+                continue;
+            }
+            term_map[term_id] = terms->Intern(segment.terms->GetTerm(term_id));
+            if (term_map[term_id] == term_sizes.size()) {
+                term_sizes.push_back(0);
+            }
+            term_sizes[term_map[term_id]] += document_freq;
+        }
+    }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
-}
\ No newline at end of file
+    PostingsPacker postings_packer(term_sizes);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const Segment& segment = *sources[i].segment;
+        for (TermId term_id = 0; term_id < term_maps[i].size(); ++term_id) {
+            if (term_maps[i][term_id] == TermDictionary::NO_TERM) {
+                continue;
+            }
+            const PostingList& postings = segment.GetPostings(term_id);
+            postings.ForEach([&](DocumentOrdinal source_ordinal, double term_freq) {
+                const DocumentOrdinal ordinal = ordinal_maps[i][source_ordinal];
+                if (ordinal != NO_ORDINAL) {
+                    postings_packer.Add(term_maps[i][term_id], ordinal, term_freq);
+                }
+                });
+        }
+    }
+    merged->terms = std::move(terms);
+    merged->term_postings.resize(term_sizes.size());
+    merged->packed_postings = postings_packer.Finish();
+    std::sort(new_ordinals.begin(), new_ordinals.end());
+    merged->AddDocumentIds(new_ordinals);
+    merged->is_sealed = true;
+    return merged;
+}
+
+std::shared_ptr<const SearchServer::Segment> SearchServer::MergeIndex(const Index& index) const {
+    if (index.segments.size() == 1 && !index.segments.front().tombstones) {
+        return index.segments.front().segment;
+    }
+    std::vector<std::vector<DocumentOrdinal>> ordinal_maps;
+    return MergeSegments(index.segments, ordinal_maps);
+}
+
+size_t SearchServer::GetMergeTier(const IndexSegment& index_segment) {
+    size_t tier = 0;
+    for (size_t tier_size = WRITE_BUFFER_SIZE * MERGE_FACTOR; index_segment.GetDocumentCount() >= tier_size;
+        tier_size *= MERGE_FACTOR) {
+        ++tier;
+    }
+    return tier;
+}
+
+std::optional<std::pair<size_t, size_t>> SearchServer::SelectMerge(const Index& index) {
+    const std::vector<IndexSegment>& segments = index.segments;
+    size_t sealed_count = segments.size();
+    if (sealed_count > 0 && !segments.back().segment->is_sealed) {
+        --sealed_count;
+    }
+
+    for (size_t i = 0; i < sealed_count; ++i) {
+        if (segments[i].tombstones && segments[i].tombstones->count > segments[i].segment->size() * MAX_DELETED_FRACTION) {
+            return std::pair{ i, i + 1 };
+        }
+    }
+
+    size_t run_first = 0;
+    for (size_t i = 0; i < sealed_count; ++i) {
+        if (GetMergeTier(segments[i]) != GetMergeTier(segments[run_first])) {
+            run_first = i;
+        }
+        if (i + 1 - run_first == MERGE_FACTOR) {
+            return std::pair{ run_first, i + 1 };
+        }
+    }
+
+    if (sealed_count > MAX_SEGMENT_COUNT) {
+        size_t best_first = 0;
+        size_t best_document_count = std::numeric_limits<size_t>::max();
+        for (size_t first = 0; first + MERGE_FACTOR <= sealed_count; ++first) {
+            size_t document_count = 0;
+            for (size_t i = first; i < first + MERGE_FACTOR; ++i) {
+                document_count += segments[i].GetDocumentCount();
+            }
+            if (document_count < best_document_count) {
+                best_first = first;
+                best_document_count = document_count;
+            }
+        }
+        return std::pair{ best_first, best_first + MERGE_FACTOR };
+    }
+    return std::nullopt;
+}
+
+bool SearchServer::MergeNextSegments() {
+    const std::shared_ptr<const Index> index = GetIndex();
+    const std::optional<std::pair<size_t, size_t>> range = SelectMerge(*index);
+    if (!range) {
+        return false;
+    }
+    const std::span<const IndexSegment> sources(index->segments.data() + range->first, range->second - range->first);
+    std::vector<std::vector<DocumentOrdinal>> ordinal_maps;
+    IndexSegment merged{ MergeSegments(sources, ordinal_maps), nullptr };
+
+    std::lock_guard guard(write_mutex_);
+    const std::shared_ptr<const Index> current_index = GetIndex();
+    //   ,      , 
+    //         CompactStorage
+    const std::vector<IndexSegment>& segments = current_index->segments;
+    const auto first = std::find_if(segments.begin(), segments.end(), [&sources](const IndexSegment& index_segment) {
+        return index_segment.segment == sources.front().segment;
+        });
+    const bool is_replaced = static_cast<size_t>(segments.end() - first) < sources.size()
+        || !std::equal(sources.begin(), sources.end(), first, [](const IndexSegment& lhs, const IndexSegment& rhs) {
+            return lhs.segment == rhs.segment;
+            });
+    if (is_replaced) {
+        return true;
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const std::shared_ptr<const Tombstones>& tombstones = first[i].tombstones;
+        if (!tombstones || tombstones == sources[i].tombstones) {
+            continue;
+        }
+        for (size_t word = 0; word < tombstones->deleted.size(); ++word) {
+            uint64_t bits = tombstones->deleted[word];
+            if (sources[i].tombstones && word < sources[i].tombstones->deleted.size()) {
+                bits &= ~sources[i].tombstones->deleted[word];
+            }
+            for (; bits != 0; bits &= bits - 1) {
+                const DocumentOrdinal ordinal = static_cast<DocumentOrdinal>(word * 64 + std::countr_zero(bits));
+                AddTombstone(merged, ordinal_maps[i][ordinal]);
+            }
+        }
+    }
+
+    auto new_index = std::make_shared<Index>(*current_index);
+    const auto position = new_index->segments.erase(new_index->segments.begin() + (first - segments.begin()),
+        new_index->segments.begin() + (first - segments.begin()) + sources.size());
+    if (merged.segment->size() > 0) {
+        new_index->segments.insert(position, std::move(merged));
+    }
+    PublishIndex(std::move(new_index));
+    return true;
+}
+
+void SearchServer::RequestMerge() {
+    {
+        std::lock_guard guard(merge_mutex_);
+        merge_requested_ = true;
+    }
+    merge_condition_.notify_one();
+}
+
+void SearchServer::RunMerges(std::stop_token stop_token) {
+    while (true) {
+        {
+            std::unique_lock guard(merge_mutex_);
+            if (!merge_condition_.wait(guard, stop_token, [this]() { return merge_requested_; })) {
+                return;
+            }
+            merge_requested_ = false;
+        }
+        while (!stop_token.stop_requested() && MergeNextSegments()) {
+        }
+    }
+}
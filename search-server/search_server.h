@@ -3,21 +3,44 @@
 #include <algorithm>
 #include <map>
 #include <set>
-#include <deque>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <utility>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <bit>
 #include <cmath>
-#include <regex> 
+#include <cstdint>
 #include <execution>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <exception>
+#include <unordered_map>
+#include <condition_variable>
+#include <stop_token>
 #include <stdlib.h>
 
 #include "document.h"
 #include "read_input_functions.h"
 #include "string_processing.h"
-#include "concurrent_map.h"
+#include "posting_list.h"
+#include "term_dictionary.h"
+#include "term_pool.h"
+#include "text_arena.h"
+#include "index_file.h"
+#include "mapped_column.h"
+#include "operation_log.h"
+#include "result_cache.h"
+#include "query_metrics.h"
+#include "profiler.h"
 
 
 using namespace std::string_literals;
@@ -35,9 +58,29 @@ public:
 
     explicit SearchServer(const std::string& stop_words_text);
 
+    //    ,  SaveIndex.  
+    //    ,     .
+    explicit SearchServer(std::shared_ptr<const IndexFile> index_file);
+
+    void SaveIndex(const std::string& path) const;
+
+    //   :   ,  
+    //    ,      .
+    // AddDocument  RemoveDocument    ,  
+    //   ;     fdatasync.
+    void OpenOperationLog(const std::string& path);
+
+    //    index_path      
+    void Checkpoint(const std::string& index_path);
+
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status,
         const std::vector<int>& ratings);
 
+    template <typename ExecutionPolicy>
+    void AddDocuments(const ExecutionPolicy& policy, const std::vector<NewDocument>& documents);
+
+    void AddDocuments(const std::vector<NewDocument>& documents);
+
     template <typename ExecutionPolicy, typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query,
         DocumentPredicate document_predicate) const;
@@ -56,12 +99,107 @@ public:
 
     std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
 
+    //     .   (, 
+    //  )        ,
+    //     .  
+    //      .
+    class QueryContext;
+
+    //    context       
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+        const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template <typename ExecutionPolicy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+        const std::string_view raw_query, DocumentStatus status) const;
+
+    template <typename ExecutionPolicy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+        const std::string_view raw_query) const;
+
+    //  :    , 
+    //   .      
+    // .    :   , 
+    //      ,  
+    //   .
+    class PreparedQuery;
+
+    PreparedQuery PrepareQuery(const std::string_view raw_query) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+        DocumentPredicate document_predicate) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+        DocumentStatus status) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query) const;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+        const PreparedQuery& query, DocumentPredicate document_predicate) const;
+
+    template <typename ExecutionPolicy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+        const PreparedQuery& query, DocumentStatus status) const;
+
+    template <typename ExecutionPolicy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+        const PreparedQuery& query) const;
+
+    //    -     
+    //   .     , 
+    //  ;    ,    .
+    class QueryPart;
+
+    //  ,  ,     max_part_posting_count
+    //  -. ,     PrepareQuery
+    std::vector<QueryPart> SplitQuery(const PreparedQuery& query, size_t max_part_posting_count) const;
+
+    //      ACTUAL,   
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, const PreparedQuery& query,
+        const QueryPart& part) const;
+
+    //          
+    // .      
+    void MergeTopDocuments(std::vector<Document>& documents) const;
+
+    SearchServer(const SearchServer&) = delete;
+
+    SearchServer& operator=(const SearchServer&) = delete;
+
     int GetDocumentCount() const;
 
-    std::set<int>::const_iterator begin();
+    void SetMaxResultDocumentCount(size_t max_result_document_count);
+
+    size_t GetMaxResultDocumentCount() const;
+
+    //   FindTopDocuments     .
+    //     .  0 ( )  .
+    void SetResultCacheCapacity(size_t max_entries);
+
+    ResultCache::Stats GetResultCacheStats() const;
+
+    //    FindTopDocuments    
+    //       ResetMetrics
+    QueryMetrics::Snapshot GetMetrics() const;
 
-    std::set<int>::const_iterator end();
+    void ResetMetrics();
 
+    //  id   .  begin()  
+    // ,   ,      
+    //  . end()           
+    class DocumentIdIterator;
+
+    DocumentIdIterator begin();
+
+    DocumentIdIterator end();
+
+    //   .   , 
+    //      .
     void RemoveDocument(int document_id);
 
     template <typename ExecutionPolicy>
@@ -78,19 +216,199 @@ public:
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy& policy,
         const std::string_view raw_query, int document_id) const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const PreparedQuery& query,
+        int document_id) const;
+
+    //   .    ,  
+    //     ,   CompactStorage
+    class WordFrequencies;
+
+    WordFrequencies GetWordFrequencies(int document_id) const;
+
+    //      ,  
+    //    ,    . 
+    //      ,   .
+    //   ,       .
+    void CompactStorage();
+
+    size_t GetStorageSize() const;
 
 private:
+    using TermId = TermDictionary::TermId;
+
     struct DocumentData {
-        int rating;
-        DocumentStatus status;
         std::map<std::string_view, double> freq;
+        TextArena::StoredText text;
+    };
+
+    // ,   .     
+    //        .
+    struct MappedIndex {
+        std::shared_ptr<const IndexFile> file;
+        std::shared_ptr<const TermDictionary> terms;
+        std::span<const uint64_t> text_offsets;
+        std::span<const char> texts;
+        std::span<const uint64_t> term_offsets;
+        std::span<const TermId> document_terms;
+        std::span<const double> word_freqs;
+        mutable std::mutex documents_mutex;
+        mutable std::unordered_map<DocumentOrdinal, std::shared_ptr<const DocumentData>> documents;
+
+        std::string_view GetText(DocumentOrdinal ordinal) const;
+
+        std::span<const TermId> GetTerms(DocumentOrdinal ordinal) const;
+
+        std::shared_ptr<const DocumentData> GetDocumentData(DocumentOrdinal ordinal) const;
+    };
+
+    //    :    
+    //   ,   .   
+    //      ,  
+    //   .
+    struct PackedPostings {
+        std::vector<uint8_t> block_data;
+        std::vector<PostingBlockHeader> blocks;
+        std::vector<double> term_freq_table;
+        std::vector<PostingList> lists;
+        std::shared_ptr<const IndexFile> file;
     };
-    std::deque<std::string> documents_storage;
+
+    class PostingsPacker {
+    public:
+        explicit PostingsPacker(const std::vector<size_t>& list_sizes);
+
+        //        
+        void Add(TermId term_id, DocumentOrdinal ordinal, double term_freq);
+
+        std::shared_ptr<const PackedPostings> Finish();
+
+    private:
+        std::vector<DocumentOrdinal> ordinals_;
+        std::vector<double> term_freqs_;
+        std::vector<size_t> offsets_;
+        std::vector<size_t> ends_;
+        std::vector<double> max_term_freqs_;
+    };
+
+    //         .
+    //    :   
+    //   ,     ,  
+    //     .
+    struct Segment {
+        std::shared_ptr<const TermDictionary> terms;
+        // nullptr ,     packed_postings
+        std::vector<std::shared_ptr<const PostingList>> term_postings;
+        std::shared_ptr<const PackedPostings> packed_postings;
+        MappedColumn<int> document_ids;
+        MappedColumn<DocumentOrdinal> document_ordinals;
+        //  ,    , 
+        //    GetMappedDocumentCount()
+        std::vector<std::shared_ptr<const DocumentData>> ordinal_documents;
+        MappedColumn<int> ordinal_to_document_id;
+        MappedColumn<int> ordinal_ratings;
+        MappedColumn<DocumentStatus> ordinal_statuses;
+        std::shared_ptr<const MappedIndex> mapped;
+        bool is_sealed = false;
+
+        DocumentOrdinal size() const;
+
+        const PostingList& GetPostings(TermId term_id) const;
+
+        TermId FindDocumentTerm(std::string_view word, DocumentOrdinal ordinal) const;
+
+        DocumentOrdinal GetMappedDocumentCount() const;
+
+        const DocumentData* FindStoredDocument(DocumentOrdinal ordinal) const;
+
+        std::shared_ptr<const DocumentData> GetDocumentData(DocumentOrdinal ordinal) const;
+
+        std::vector<TermId> GetDocumentTerms(DocumentOrdinal ordinal) const;
+
+        //  id       :   document_ids
+        //   id,      
+        void AddDocumentIds(const std::vector<std::pair<int, DocumentOrdinal>>& sorted_ordinals);
+    };
+
+    //   
+    struct Tombstones {
+        std::vector<uint64_t> deleted;
+        //     ,   TermId
+        std::vector<std::pair<TermId, DocumentOrdinal>> term_counts;
+        DocumentOrdinal count = 0;
+
+        bool IsDeleted(DocumentOrdinal ordinal) const;
+
+        DocumentOrdinal GetTermCount(TermId term_id) const;
+    };
+
+    struct IndexSegment {
+        std::shared_ptr<const Segment> segment;
+        std::shared_ptr<const Tombstones> tombstones;
+
+        bool IsDeleted(DocumentOrdinal ordinal) const;
+
+        //       id
+        std::optional<DocumentOrdinal> FindOrdinal(int document_id) const;
+
+        size_t GetDocumentCount() const;
+
+        //    ,  
+        size_t GetDocumentFreq(TermId term_id) const;
+    };
+
+    struct DocumentLocation {
+        size_t segment;
+        DocumentOrdinal ordinal;
+    };
+
+    struct DocumentIdList {
+        std::once_flag once;
+        std::vector<int> ids;
+    };
+
+    //          .
+    //      ;   write_mutex_
+    //  ,     ,    .
+    struct Index {
+        std::vector<IndexSegment> segments;
+        size_t document_count = 0;
+        double log_document_count = -std::numeric_limits<double>::infinity();
+        // log(n)  n  0  document_count:     
+        // ,  idf    ,   
+        //    .       
+        std::shared_ptr<const std::vector<double>> log_document_freqs
+            = std::make_shared<const std::vector<double>>(1, -std::numeric_limits<double>::infinity());
+        //       .   
+        //     
+        uint64_t generation = 0;
+        //  id     . ,
+        //  ,    .
+        std::shared_ptr<DocumentIdList> document_ids = std::make_shared<DocumentIdList>();
+
+        std::optional<DocumentLocation> FindDocument(int document_id) const;
+
+        DocumentLocation GetDocument(int document_id) const;
+
+        const std::vector<int>& GetDocumentIds() const;
+    };
+
+    TextArena documents_storage;
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
+    std::shared_ptr<TermPool> term_pool_ = std::make_shared<TermPool>();
+    //         ,
+    //       
+    std::shared_ptr<const IndexFile> index_file_;
+    std::atomic<std::shared_ptr<const Index>> index_ = std::make_shared<const Index>();
+    mutable std::mutex write_mutex_;
+    std::atomic<size_t> max_result_document_count_ = MAX_RESULT_DOCUMENT_COUNT;
+    mutable ResultCache result_cache_;
+    mutable QueryMetrics query_metrics_;
+    std::unique_ptr<OperationLog> operation_log_;
+    //    ,   .  write_mutex_
+    uint64_t log_sequence_ = 0;
+    std::mutex merge_mutex_;
+    std::condition_variable_any merge_condition_;
+    bool merge_requested_ = false;
 
 
     struct QueryWord {
@@ -104,25 +422,296 @@ private:
         std::vector<std::string_view> minus_words;
     };
 
+    // ,    . ,  
+    //    , .
+    struct SegmentQuery {
+        std::vector<const PostingList*> plus_postings;
+        std::vector<double> inverse_document_freqs;
+        std::vector<const PostingList*> minus_postings;
+    };
+
+    //       
+    //    ,     
+    struct TermCursor {
+        const PostingList* postings;
+        PostingList::BlockBuffer* buffer;
+        PostingList::Block block;
+        size_t block_index;
+        size_t block_count;
+        size_t pos;
+        double inverse_document_freq;
+        double max_score;
+
+        TermCursor(const PostingList& postings, PostingList::BlockBuffer& buffer, double inverse_document_freq = 0.0);
+
+        bool AtEnd() const;
+
+        DocumentOrdinal Current() const;
+
+        double GetTermFreq() const;
+
+        void Next();
+
+        bool SeekTo(DocumentOrdinal ordinal);
+
+        void LoadBlock(size_t index);
+    };
+
     bool IsStopWord(const std::string_view word) const;
 
     static bool IsValidWord(const std::string_view word);
 
     static bool IsInvalidQuery(const std::string& text);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string& text) const;
+    //    -. words    
+    //   .
+    void SplitIntoWordsNoStop(const std::string_view text, std::vector<std::string_view>& words) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
-    QueryWord ParseQueryWord(std::string_view text) const;
+    static std::shared_ptr<Segment> MapIndex(std::shared_ptr<const IndexFile> index_file);
+
+    //       
+    void WriteIndexFile(const IndexSegment& index_segment, uint64_t log_sequence, const std::string& path) const;
+
+    uint64_t LogAddDocument(int document_id, const std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings);
+
+    uint64_t LogRemoveDocument(int document_id);
+
+    void WaitForOperationLog(uint64_t log_sequence);
+
+    static void CheckNewDocumentIds(const Index& index, std::vector<int> document_ids);
+
+    //    ,     : 
+    //       
+    static void CheckDocumentText(const std::string_view text);
+
+    static bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+    QueryWord ParseQueryWord(std::string_view text, bool is_valid) const;
 
     QueryNew ParseQuery(const std::string_view text) const;
 
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    // words -    
+    void ParseQuery(const std::string_view text, std::vector<std::string_view>& words, QueryNew& result) const;
+
+    std::shared_ptr<const Index> GetIndex() const;
+
+    void PublishIndex(std::shared_ptr<Index> index);
 
+    static void UpdateLogTables(Index& index);
+
+    std::shared_ptr<Segment> MakeSegment() const;
+
+    static void SealWriteBuffer(Index& index);
+
+    static void AddTombstone(IndexSegment& index_segment, DocumentOrdinal ordinal);
+
+    //  ,   . ordinal_maps[i][ordinal] 
+    //     ordinal  sources[i]  NO_ORDINAL.
+    std::shared_ptr<Segment> MergeSegments(std::span<const IndexSegment> sources,
+        std::vector<std::vector<DocumentOrdinal>>& ordinal_maps) const;
+
+    std::shared_ptr<const Segment> MergeIndex(const Index& index) const;
+
+    static size_t GetMergeTier(const IndexSegment& index_segment);
+
+    static std::optional<std::pair<size_t, size_t>> SelectMerge(const Index& index);
+
+    bool MergeNextSegments();
+
+    void RequestMerge();
+
+    void RunMerges(std::stop_token stop_token);
+
+    static void ComputeInverseDocumentFreqs(const Index& index, const std::vector<std::string_view>& words,
+        std::vector<double>& inverse_document_freqs);
+
+    //  -    , - -  :
+    //     ,    
+    static void ResolveQuery(const IndexSegment& index_segment, const QueryNew& query,
+        const std::vector<double>& inverse_document_freqs, SegmentQuery& segment_query);
+
+    //     index
+    static void ResolveQuery(const Index& index, const QueryNew& query, std::vector<double>& inverse_document_freqs,
+        std::vector<SegmentQuery>& segment_queries);
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const QueryNew& query,
+        int document_id) const;
+
+    //  ,   index: segment_queries[i]   index.segments[i]
     template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const ExecutionPolicy& policy, const QueryNew& query,
-        DocumentPredicate document_predicate) const;
+    static const std::vector<Document>& ExecuteQuery(QueryContext& context, const ExecutionPolicy& policy, const Index& index,
+        std::span<const SegmentQuery> segment_queries, DocumentPredicate document_predicate,
+        size_t max_result_document_count);
+
+    //   : ,      
+    static void MakeResultCacheKey(const QueryNew& query, DocumentStatus status, size_t max_result_document_count,
+        std::string& key);
+
+    template <typename ExecutionPolicy>
+    static size_t GetChunkCount(const ExecutionPolicy& policy, size_t item_count, size_t min_chunk_size);
+
+    //     context.documents_
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    static void FindAllDocuments(const ExecutionPolicy& policy, const Index& index,
+        std::span<const SegmentQuery> segment_queries, QueryContext& context, DocumentPredicate document_predicate);
+
+    template <typename DocumentPredicate>
+    static void FindTopDocumentsPruned(const Index& index, std::span<const SegmentQuery> segment_queries,
+        QueryContext& context, DocumentPredicate document_predicate, size_t max_result_document_count);
+
+    //   context.documents_       [first_ordinal, last_ordinal)
+    template <typename DocumentPredicate>
+    static void CollectTopDocumentsPruned(const IndexSegment& index_segment, const SegmentQuery& query,
+        QueryContext& context, DocumentPredicate document_predicate, size_t max_result_document_count,
+        DocumentOrdinal first_ordinal = 0, DocumentOrdinal last_ordinal = std::numeric_limits<DocumentOrdinal>::max());
+
+    template <typename DocumentPredicate>
+    static void FindAllDocumentsSparse(const IndexSegment& index_segment, const SegmentQuery& query,
+        QueryContext& context, DocumentPredicate document_predicate);
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    static void FindAllDocumentsDense(const ExecutionPolicy& policy, const IndexSegment& index_segment,
+        const SegmentQuery& query, QueryContext& context, DocumentPredicate document_predicate);
+
+    static constexpr size_t SPARSE_ACCUMULATOR_RATIO = 16;
+    static constexpr size_t MIN_ACCUMULATOR_CHUNK_SIZE = 4096;
+    static constexpr size_t MIN_INGESTION_CHUNK_SIZE = 256;
+    static constexpr double MIN_STORAGE_UTILIZATION = 0.5;
+    static constexpr size_t MIN_LOG_TABLE_SIZE = 1024;
+    static constexpr DocumentOrdinal PRUNING_WINDOW_SIZE = 1024;
+    static constexpr DocumentOrdinal NO_ORDINAL = std::numeric_limits<DocumentOrdinal>::max();
+    //   ,   
+    static constexpr DocumentOrdinal WRITE_BUFFER_SIZE = 1024;
+    //         
+    static constexpr size_t MERGE_FACTOR = 4;
+    //          
+    static constexpr size_t MAX_SEGMENT_COUNT = 16;
+    //  ,       
+    static constexpr double MAX_DELETED_FRACTION = 0.3;
+
+    //  :  ,    
+    // ,     
+    std::jthread merge_thread_{ [this](std::stop_token stop_token) { RunMerges(stop_token); } };
+};
+
+class SearchServer::QueryContext {
+private:
+    friend class SearchServer;
+
+    //       
+    struct AccumulatorChunk {
+        std::vector<double> relevances;
+        std::vector<char> is_matched;
+        std::vector<uint64_t> excluded;
+        std::vector<Document> documents;
+        size_t documents_scored = 0;
+        size_t documents_filtered = 0;
+    };
+
+    std::vector<std::string_view> words_;
+    QueryNew query_;
+    std::vector<double> inverse_document_freqs_;
+    std::vector<SegmentQuery> segment_queries_;
+    std::vector<std::unique_ptr<PostingList::BlockBuffer>> block_buffers_;
+    std::vector<TermCursor> cursors_;
+    std::vector<TermCursor> minus_cursors_;
+    std::vector<double> max_score_prefix_;
+    std::vector<double> window_relevances_;
+    std::vector<uint64_t> window_matched_;
+    std::vector<uint64_t> window_excluded_;
+    std::vector<std::pair<DocumentOrdinal, double>> ordinal_relevances_;
+    std::vector<size_t> chunk_indexes_;
+    std::vector<AccumulatorChunk> chunks_;
+    std::vector<Document> documents_;
+    std::string cache_key_;
+    QueryMetrics::Sample metrics_;
+
+    PostingList::BlockBuffer& GetBlockBuffer(size_t index);
+};
+
+class SearchServer::PreparedQuery {
+private:
+    friend class SearchServer;
+
+    //     text_,      
+    std::shared_ptr<const std::string> text_;
+    QueryNew query_;
+    std::weak_ptr<const Index> index_;
+    std::vector<SegmentQuery> segment_queries_;
+
+public:
+    //   -,   , -   
+    size_t GetPostingCount() const;
+};
+
+class SearchServer::QueryPart {
+private:
+    friend class SearchServer;
+
+    std::shared_ptr<const Index> index_;
+    size_t segment_ = 0;
+    DocumentOrdinal first_ordinal_ = 0;
+    DocumentOrdinal last_ordinal_ = 0;
+};
+
+class SearchServer::DocumentIdIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int*;
+    using reference = const int&;
+
+    DocumentIdIterator() = default;
+
+    reference operator*() const;
+
+    DocumentIdIterator& operator++();
+
+    DocumentIdIterator operator++(int);
+
+    bool operator==(const DocumentIdIterator& other) const;
+
+private:
+    friend class SearchServer;
+
+    std::shared_ptr<const Index> index_;
+    const std::vector<int>* document_ids_ = nullptr;
+    size_t position_ = 0;
+
+    bool IsEnd() const;
+};
+
+class SearchServer::WordFrequencies {
+public:
+    using Map = std::map<std::string_view, double>;
+    using const_iterator = Map::const_iterator;
+
+    const_iterator begin() const;
+
+    const_iterator end() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    size_t count(std::string_view word) const;
+
+    double at(std::string_view word) const;
+
+    const Map& Get() const;
+
+    bool operator==(const WordFrequencies& other) const;
+
+private:
+    friend class SearchServer;
+
+    //          ,  
+    //  ,    
+    std::shared_ptr<const Map> freqs_;
 };
 
 void RemoveDuplicates(SearchServer& search_server);
@@ -138,10 +727,9 @@ SearchServer::SearchServer(const StringContainer& stop_words)
 
 template <typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy,
-        raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+    QueryContext context;
+    FindTopDocuments(context, policy, raw_query, status);
+    return std::move(context.documents_);
 }
 
 template <typename ExecutionPolicy>
@@ -152,113 +740,589 @@ std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& poli
 template <typename ExecutionPolicy, typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const std::string_view raw_query,
     DocumentPredicate document_predicate) const {
-    auto query = ParseQuery(raw_query);
+    QueryContext context;
+    FindTopDocuments(context, policy, raw_query, document_predicate);
+    return std::move(context.documents_);
+}
+
+template <typename ExecutionPolicy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+    const std::string_view raw_query, DocumentStatus status) const {
+    const auto document_predicate = [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    };
+    if (!result_cache_.IsEnabled()) {
+        return FindTopDocuments(context, policy, raw_query, document_predicate);
+    }
+
+    QueryMetrics::Sample& metrics = context.metrics_;
+    metrics.Start();
+    const std::shared_ptr<const Index> index = GetIndex();
+    QueryNew& query = context.query_;
+    ParseQuery(raw_query, context.words_, query);
 
     MakeUniqueVector(query.minus_words);
     MakeUniqueVector(query.plus_words);
+    const size_t max_result_document_count = GetMaxResultDocumentCount();
+    MakeResultCacheKey(query, status, max_result_document_count, context.cache_key_);
+    metrics.EndPhase(QueryMetrics::Phase::PARSE);
+    if (result_cache_.Find(context.cache_key_, index->generation, context.documents_)) {
+        metrics.EndPhase(QueryMetrics::Phase::MATERIALIZE);
+        query_metrics_.Record(metrics, context.documents_.size());
+        return context.documents_;
+    }
+    ResolveQuery(*index, query, context.inverse_document_freqs_, context.segment_queries_);
+    metrics.EndPhase(QueryMetrics::Phase::RESOLVE);
+    ExecuteQuery(context, policy, *index, context.segment_queries_, document_predicate, max_result_document_count);
+    result_cache_.Insert(context.cache_key_, index->generation, context.documents_);
+    metrics.EndPhase(QueryMetrics::Phase::MATERIALIZE);
+    query_metrics_.Record(metrics, context.documents_.size());
+    return context.documents_;
+}
 
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+template <typename ExecutionPolicy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+    const std::string_view raw_query) const {
+    return FindTopDocuments(context, policy, raw_query, DocumentStatus::ACTUAL);
+}
 
-    std::sort(policy, matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < INACCURACY) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
+template <typename ExecutionPolicy, typename DocumentPredicate>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+    const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    QueryMetrics::Sample& metrics = context.metrics_;
+    metrics.Start();
+    const std::shared_ptr<const Index> index = GetIndex();
+    QueryNew& query = context.query_;
+    ParseQuery(raw_query, context.words_, query);
+
+    MakeUniqueVector(query.minus_words);
+    MakeUniqueVector(query.plus_words);
+    metrics.EndPhase(QueryMetrics::Phase::PARSE);
+    ResolveQuery(*index, query, context.inverse_document_freqs_, context.segment_queries_);
+    metrics.EndPhase(QueryMetrics::Phase::RESOLVE);
+    ExecuteQuery(context, policy, *index, context.segment_queries_, document_predicate, GetMaxResultDocumentCount());
+    query_metrics_.Record(metrics, context.documents_.size());
+    return context.documents_;
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+    DocumentPredicate document_predicate) const {
+    QueryContext context;
+    FindTopDocuments(context, policy, query, document_predicate);
+    return std::move(context.documents_);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query,
+    DocumentStatus status) const {
+    return FindTopDocuments(policy,
+        query, [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
+        });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, const PreparedQuery& query) const {
+    return FindTopDocuments(policy, query, DocumentStatus::ACTUAL);
+}
+
+template <typename ExecutionPolicy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+    const PreparedQuery& query, DocumentStatus status) const {
+    return FindTopDocuments(context, policy,
+        query, [status](int, DocumentStatus document_status, int) {
+            return document_status == status;
         });
+}
+
+template <typename ExecutionPolicy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+    const PreparedQuery& query) const {
+    return FindTopDocuments(context, policy, query, DocumentStatus::ACTUAL);
+}
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename ExecutionPolicy, typename DocumentPredicate>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, const ExecutionPolicy& policy,
+    const PreparedQuery& query, DocumentPredicate document_predicate) const {
+    QueryMetrics::Sample& metrics = context.metrics_;
+    metrics.Start();
+    const std::shared_ptr<const Index> index = GetIndex();
+    if (query.index_.lock() == index) {
+        ExecuteQuery(context, policy, *index, query.segment_queries_, document_predicate, GetMaxResultDocumentCount());
+    }
+    else {
+        ResolveQuery(*index, query.query_, context.inverse_document_freqs_, context.segment_queries_);
+        metrics.EndPhase(QueryMetrics::Phase::RESOLVE);
+        ExecuteQuery(context, policy, *index, context.segment_queries_, document_predicate, GetMaxResultDocumentCount());
+    }
+    query_metrics_.Record(metrics, context.documents_.size());
+    return context.documents_;
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+const std::vector<Document>& SearchServer::ExecuteQuery(QueryContext& context, const ExecutionPolicy& policy,
+    const Index& index, std::span<const SegmentQuery> segment_queries, DocumentPredicate document_predicate,
+    size_t max_result_document_count) {
+    std::vector<Document>& matched_documents = context.documents_;
+    if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+        FindTopDocumentsPruned(index, segment_queries, context, document_predicate, max_result_document_count);
+        return matched_documents;
     }
+
+    FindAllDocuments(policy, index, segment_queries, context, document_predicate);
+
+    const size_t result_count = std::min(matched_documents.size(), max_result_document_count);
+    std::partial_sort(policy, matched_documents.begin(), matched_documents.begin() + result_count, matched_documents.end(),
+        IsMoreRelevant);
+    context.metrics_.EndPhase(QueryMetrics::Phase::TOP_K);
+    matched_documents.resize(result_count);
+    context.metrics_.EndPhase(QueryMetrics::Phase::MATERIALIZE);
     return matched_documents;
 }
 
+template <typename ExecutionPolicy>
+size_t SearchServer::GetChunkCount(const ExecutionPolicy&, size_t item_count, size_t min_chunk_size) {
+    if constexpr (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
+        return 1;
+    }
+    else {
+        const size_t max_chunk_count = std::max(1u, std::thread::hardware_concurrency()) * 4;
+        return std::clamp<size_t>(item_count / min_chunk_size, 1, max_chunk_count);
+    }
+}
+
 template <typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const ExecutionPolicy& policy, const QueryNew& query,
-    DocumentPredicate document_predicate) const {
-    //std::map<int, double> document_to_relevance;
-
-    ConcurrentMap<int, double> document_to_relevance(10);
-
-    /*
-    std::for_each(policy, query.plus_words.begin(), query.plus_words.end(), [this, &policy, &document_to_relevance, &document_predicate]
-    (const std::string_view word) {
-        if (word_to_document_freqs_.count(word) == 1) {
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-
-            std::for_each(policy, word_to_document_freqs_.at(word).begin(), word_to_document_freqs_.at(word).end(), 
-                [this, policy, &document_to_relevance, &inverse_document_freq, &document_predicate]
-            (const std::pair<int, double> term_freq) {
-                    const auto& document_data = documents_.at(term_freq.first);
-                    if (document_predicate(term_freq.first, document_data.status, document_data.rating)) {
-                        document_to_relevance[term_freq.first] += term_freq.second * inverse_document_freq;
-                    }
-                });
+void SearchServer::FindAllDocuments(const ExecutionPolicy& policy, const Index& index,
+    std::span<const SegmentQuery> segment_queries, QueryContext& context, DocumentPredicate document_predicate) {
+    PROFILE_SCOPE("SearchServer::FindAllDocuments");
+    context.documents_.clear();
+    for (size_t i = 0; i < index.segments.size(); ++i) {
+        const IndexSegment& index_segment = index.segments[i];
+        const SegmentQuery& segment_query = segment_queries[i];
+        size_t posting_count = 0;
+        for (const PostingList* postings : segment_query.plus_postings) {
+            posting_count += postings->size();
         }
+        if (posting_count == 0) {
+            continue;
+        }
+        context.metrics_.postings_scanned += posting_count;
+        if (posting_count * SPARSE_ACCUMULATOR_RATIO < index_segment.segment->size()) {
+            FindAllDocumentsSparse(index_segment, segment_query, context, document_predicate);
+        }
+        else {
+            FindAllDocumentsDense(policy, index_segment, segment_query, context, document_predicate);
+        }
+    }
+    context.metrics_.EndPhase(QueryMetrics::Phase::TRAVERSE);
+}
+
+template <typename DocumentPredicate>
+void SearchServer::FindTopDocumentsPruned(const Index& index, std::span<const SegmentQuery> segment_queries,
+    QueryContext& context, DocumentPredicate document_predicate, size_t max_result_document_count) {
+    PROFILE_SCOPE("SearchServer::FindTopDocumentsPruned");
+    std::vector<Document>& top_documents = context.documents_;
+    top_documents.clear();
+    if (max_result_document_count == 0) {
+        return;
+    }
+    // ,    ,    
+    for (size_t i = 0; i < index.segments.size(); ++i) {
+        CollectTopDocumentsPruned(index.segments[i], segment_queries[i], context, document_predicate, max_result_document_count);
+    }
+    context.metrics_.EndPhase(QueryMetrics::Phase::TRAVERSE);
+    std::sort_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+    context.metrics_.EndPhase(QueryMetrics::Phase::TOP_K);
+}
+
+template <typename DocumentPredicate>
+void SearchServer::CollectTopDocumentsPruned(const IndexSegment& index_segment, const SegmentQuery& query,
+    QueryContext& context, DocumentPredicate document_predicate, size_t max_result_document_count,
+    DocumentOrdinal first_ordinal, DocumentOrdinal last_ordinal) {
+    const Segment& segment = *index_segment.segment;
+    std::vector<Document>& top_documents = context.documents_;
+
+    std::vector<TermCursor>& cursors = context.cursors_;
+    cursors.clear();
+    for (size_t i = 0; i < query.plus_postings.size(); ++i) {
+        cursors.emplace_back(*query.plus_postings[i], context.GetBlockBuffer(i), query.inverse_document_freqs[i]);
+        if (first_ordinal > 0) {
+            cursors.back().SeekTo(first_ordinal);
+        }
+    }
+    std::sort(cursors.begin(), cursors.end(), [](const TermCursor& lhs, const TermCursor& rhs) {
+        return lhs.max_score < rhs.max_score;
         });
-*/
+    std::vector<double>& max_score_prefix = context.max_score_prefix_;
+    max_score_prefix.resize(cursors.size());
+    double max_score_sum = 0.0;
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        max_score_sum += cursors[i].max_score;
+        max_score_prefix[i] = max_score_sum;
+    }
+    std::vector<TermCursor>& minus_cursors = context.minus_cursors_;
+    minus_cursors.clear();
+    for (const PostingList* postings : query.minus_postings) {
+        minus_cursors.emplace_back(*postings, context.GetBlockBuffer(cursors.size() + minus_cursors.size()));
+    }
+
+    std::vector<double>& relevances = context.window_relevances_;
+    std::vector<uint64_t>& matched = context.window_matched_;
+    std::vector<uint64_t>& excluded = context.window_excluded_;
+    relevances.assign(PRUNING_WINDOW_SIZE, 0.0);
+    matched.assign(PRUNING_WINDOW_SIZE / 64, 0);
+    excluded.resize(PRUNING_WINDOW_SIZE / 64);
+
+    //  cursors[0, first_essential)        ,
+    //       ,  
+    //      .
+    size_t first_essential = 0;
+    double threshold = -std::numeric_limits<double>::infinity();
+    auto update_threshold = [&]() {
+        if (top_documents.size() == max_result_document_count) {
+            threshold = top_documents.front().relevance;
+            while (first_essential < cursors.size() && max_score_prefix[first_essential] < threshold - INACCURACY) {
+                ++first_essential;
+            }
+        }
+    };
+    update_threshold();
+
+    //     ,        
+    uint64_t postings_scanned = 0;
+    uint64_t documents_scored = 0;
+    uint64_t documents_filtered = 0;
+    while (first_essential < cursors.size()) {
+        DocumentOrdinal first = std::numeric_limits<DocumentOrdinal>::max();
+        for (size_t i = first_essential; i < cursors.size(); ++i) {
+            if (!cursors[i].AtEnd()) {
+                first = std::min(first, cursors[i].Current());
+            }
+        }
+        if (first >= last_ordinal) {
+            break;
+        }
+        const DocumentOrdinal last = first + std::min(PRUNING_WINDOW_SIZE, last_ordinal - first);
+        const size_t window_first_essential = first_essential;
+
+        std::fill(excluded.begin(), excluded.end(), 0);
+        for (TermCursor& cursor : minus_cursors) {
+            for (cursor.SeekTo(first); !cursor.AtEnd() && cursor.Current() < last; cursor.Next()) {
+                const DocumentOrdinal offset = cursor.Current() - first;
+                excluded[offset / 64] |= uint64_t{ 1 } << (offset % 64);
+                ++postings_scanned;
+            }
+        }
+        for (size_t i = window_first_essential; i < cursors.size(); ++i) {
+            TermCursor& cursor = cursors[i];
+            for (; !cursor.AtEnd() && cursor.Current() < last; cursor.Next()) {
+                const DocumentOrdinal offset = cursor.Current() - first;
+                ++postings_scanned;
+                if (excluded[offset / 64] >> (offset % 64) & 1) {
+                    continue;
+                }
+                relevances[offset] += cursor.GetTermFreq() * cursor.inverse_document_freq;
+                matched[offset / 64] |= uint64_t{ 1 } << (offset % 64);
+            }
+        }
+
+        for (size_t word = 0; word < matched.size(); ++word) {
+            for (uint64_t bits = std::exchange(matched[word], 0); bits != 0; bits &= bits - 1) {
+                const DocumentOrdinal offset = static_cast<DocumentOrdinal>(word * 64 + std::countr_zero(bits));
+                const DocumentOrdinal ordinal = first + offset;
+                double relevance = std::exchange(relevances[offset], 0.0);
+                ++documents_scored;
 
+                if (index_segment.IsDeleted(ordinal)) {
+                    ++documents_filtered;
+                    continue;
+                }
+                const int document_id = segment.ordinal_to_document_id[ordinal];
+                if (!document_predicate(document_id, segment.ordinal_statuses[ordinal], segment.ordinal_ratings[ordinal])) {
+                    ++documents_filtered;
+                    continue;
+                }
 
-std::for_each(policy, query.plus_words.begin(), query.plus_words.end(), [this, &policy, &document_to_relevance, &document_predicate]
-(const std::string_view word) {
-    if (word_to_document_freqs_.count(word) == 1) {
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
+                bool is_pruned = false;
+                for (size_t i = window_first_essential; i-- > 0;) {
+                    if (relevance + max_score_prefix[i] <= threshold - INACCURACY) {
+                        is_pruned = true;
+                        break;
+                    }
+                    ++postings_scanned;
+                    if (cursors[i].SeekTo(ordinal)) {
+                        relevance += cursors[i].GetTermFreq() * cursors[i].inverse_document_freq;
+                    }
+                }
+                if (is_pruned) {
+                    continue;
+                }
 
-        std::for_each(policy, word_to_document_freqs_.at(word).begin(), word_to_document_freqs_.at(word).end(),
-            [this, policy, &document_to_relevance, &inverse_document_freq, &document_predicate]
-        (const std::pair<int, double> term_freq) {
-                const auto& document_data = documents_.at(term_freq.first);
-                if (document_predicate(term_freq.first, document_data.status, document_data.rating)) {
-                    document_to_relevance[term_freq.first].ref_to_value += term_freq.second * inverse_document_freq;
+                const Document document(document_id, relevance, segment.ordinal_ratings[ordinal]);
+                if (top_documents.size() == max_result_document_count) {
+                    if (!IsMoreRelevant(document, top_documents.front())) {
+                        continue;
+                    }
+                    std::pop_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+                    top_documents.pop_back();
                 }
-            });
+                top_documents.push_back(document);
+                std::push_heap(top_documents.begin(), top_documents.end(), IsMoreRelevant);
+                update_threshold();
+            }
+        }
     }
-    });
+    context.metrics_.postings_scanned += postings_scanned;
+    context.metrics_.documents_scored += documents_scored;
+    context.metrics_.documents_filtered += documents_filtered;
+}
 
+template <typename DocumentPredicate>
+void SearchServer::FindAllDocumentsSparse(const IndexSegment& index_segment, const SegmentQuery& query,
+    QueryContext& context, DocumentPredicate document_predicate) {
+    const Segment& segment = *index_segment.segment;
+
+    auto is_excluded = [&index_segment, &query](const DocumentOrdinal ordinal) {
+        return index_segment.IsDeleted(ordinal)
+            || std::any_of(query.minus_postings.begin(), query.minus_postings.end(), [ordinal](const PostingList* postings) {
+                return postings->Contains(ordinal);
+                });
+    };
 
-    /*
-    for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+    std::vector<std::pair<DocumentOrdinal, double>>& ordinal_relevances = context.ordinal_relevances_;
+    ordinal_relevances.clear();
+    for (size_t i = 0; i < query.plus_postings.size(); ++i) {
+        const double inverse_document_freq = query.inverse_document_freqs[i];
+        query.plus_postings[i]->ForEach([&](DocumentOrdinal ordinal, double term_freq) {
+            if (!is_excluded(ordinal)) {
+                ordinal_relevances.emplace_back(ordinal, term_freq * inverse_document_freq);
             }
-        }
+            });
     }
-    */
-/*
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+    std::sort(ordinal_relevances.begin(), ordinal_relevances.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+
+    std::vector<Document>& matched_documents = context.documents_;
+    for (auto it = ordinal_relevances.begin(); it != ordinal_relevances.end();) {
+        const DocumentOrdinal ordinal = it->first;
+        double relevance = 0.0;
+        for (; it != ordinal_relevances.end() && it->first == ordinal; ++it) {
+            relevance += it->second;
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        const int document_id = segment.ordinal_to_document_id[ordinal];
+        ++context.metrics_.documents_scored;
+        if (document_predicate(document_id, segment.ordinal_statuses[ordinal], segment.ordinal_ratings[ordinal])) {
+            matched_documents.push_back({ document_id, relevance, segment.ordinal_ratings[ordinal] });
+        }
+        else {
+            ++context.metrics_.documents_filtered;
         }
     }
-    */
+}
 
-    std::for_each(policy, query.minus_words.begin(), query.minus_words.end(), [&policy, this, &document_to_relevance](const std::string_view word) {
-        if (word_to_document_freqs_.count(word) == 1) {
-            std::for_each(policy, word_to_document_freqs_.at(word).begin(), word_to_document_freqs_.at(word).end(),
-                [&policy, this, &document_to_relevance](const std::pair<int, double> docs_freq) {
-                    document_to_relevance.erase(docs_freq.first);
+template <typename ExecutionPolicy, typename DocumentPredicate>
+void SearchServer::FindAllDocumentsDense(const ExecutionPolicy& policy, const IndexSegment& index_segment,
+    const SegmentQuery& query, QueryContext& context, DocumentPredicate document_predicate) {
+    const Segment& segment = *index_segment.segment;
+
+    const size_t ordinal_count = segment.size();
+    const size_t chunk_count = GetChunkCount(policy, ordinal_count, MIN_ACCUMULATOR_CHUNK_SIZE);
+    const size_t chunk_size = (ordinal_count + chunk_count - 1) / chunk_count;
+
+    if (context.chunks_.size() < chunk_count) {
+        context.chunks_.resize(chunk_count);
+    }
+    std::vector<size_t>& chunks = context.chunk_indexes_;
+    chunks.resize(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+
+    std::for_each(policy, chunks.begin(), chunks.end(), [&](const size_t chunk) {
+        const DocumentOrdinal first = static_cast<DocumentOrdinal>(std::min(ordinal_count, chunk * chunk_size));
+        const DocumentOrdinal last = static_cast<DocumentOrdinal>(std::min(ordinal_count, first + chunk_size));
+        QueryContext::AccumulatorChunk& accumulator = context.chunks_[chunk];
+        std::vector<double>& relevances = accumulator.relevances;
+        std::vector<char>& is_matched = accumulator.is_matched;
+        std::vector<uint64_t>& excluded = accumulator.excluded;
+        relevances.assign(last - first, 0.0);
+        is_matched.assign(last - first, 0);
+        excluded.assign(query.minus_postings.empty() ? 0 : (last - first + 63) / 64, 0);
+        accumulator.documents.clear();
+
+        auto for_each_posting = [first, last](const PostingList& postings, auto action) {
+            postings.ForEach(first, last, [first, &action](DocumentOrdinal ordinal, double term_freq) {
+                action(ordinal - first, term_freq);
                 });
+        };
+
+        for (const PostingList* postings : query.minus_postings) {
+            for_each_posting(*postings, [&](size_t offset, double) {
+                excluded[offset / 64] |= uint64_t{ 1 } << (offset % 64);
+            });
+        }
+        for (size_t i = 0; i < query.plus_postings.size(); ++i) {
+            const double inverse_document_freq = query.inverse_document_freqs[i];
+            for_each_posting(*query.plus_postings[i], [&](size_t offset, double term_freq) {
+                if (!excluded.empty() && (excluded[offset / 64] >> (offset % 64) & 1)) {
+                    return;
+                }
+                relevances[offset] += term_freq * inverse_document_freq;
+                is_matched[offset] = 1;
+            });
+        }
+
+        size_t documents_scored = 0;
+        size_t documents_filtered = 0;
+        for (DocumentOrdinal ordinal = first; ordinal < last; ++ordinal) {
+            if (!is_matched[ordinal - first]) {
+                continue;
+            }
+            ++documents_scored;
+            if (index_segment.IsDeleted(ordinal)) {
+                ++documents_filtered;
+                continue;
+            }
+            const int document_id = segment.ordinal_to_document_id[ordinal];
+            if (document_predicate(document_id, segment.ordinal_statuses[ordinal], segment.ordinal_ratings[ordinal])) {
+                accumulator.documents.push_back({ document_id, relevances[ordinal - first], segment.ordinal_ratings[ordinal] });
+            }
+            else {
+                ++documents_filtered;
+            }
         }
+        accumulator.documents_scored = documents_scored;
+        accumulator.documents_filtered = documents_filtered;
+    });
+    context.metrics_.EndPhase(QueryMetrics::Phase::TRAVERSE);
+
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        const QueryContext::AccumulatorChunk& accumulator = context.chunks_[chunk];
+        context.documents_.insert(context.documents_.end(), accumulator.documents.begin(), accumulator.documents.end());
+        context.metrics_.documents_scored += accumulator.documents_scored;
+        context.metrics_.documents_filtered += accumulator.documents_filtered;
+    }
+    context.metrics_.EndPhase(QueryMetrics::Phase::MATERIALIZE);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocuments(const ExecutionPolicy& policy, const std::vector<NewDocument>& documents) {
+    PROFILE_SCOPE("SearchServer::AddDocuments");
+    if (documents.empty()) {
+        return;
+    }
+    std::unique_lock guard(write_mutex_);
+    auto index = std::make_shared<Index>(*GetIndex());
+
+    std::vector<int> new_document_ids(documents.size());
+    std::transform(documents.begin(), documents.end(), new_document_ids.begin(), [](const NewDocument& document) {
+        return document.id;
         });
+    CheckNewDocumentIds(*index, new_document_ids);
+    for (const NewDocument& document : documents) {
+        CheckDocumentText(document.text);
+    }
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance.BuildOrdinaryMap()) {
-        matched_documents.push_back(
-            { document_id, relevance, documents_.at(document_id).rating });
+    std::vector<TextArena::StoredText> texts;
+    texts.reserve(documents.size());
+    for (const NewDocument& document : documents) {
+        texts.push_back(documents_storage.Store(document.text));
     }
-    return matched_documents;
+
+    struct PartialIndex {
+        std::unordered_map<std::string_view, std::vector<std::pair<DocumentOrdinal, double>>> word_postings;
+        std::exception_ptr error;
+    };
+    const size_t chunk_count = GetChunkCount(policy, documents.size(), MIN_INGESTION_CHUNK_SIZE);
+    const size_t chunk_size = (documents.size() + chunk_count - 1) / chunk_count;
+    std::vector<PartialIndex> partial_indexes(chunk_count);
+    std::vector<std::shared_ptr<DocumentData>> documents_data(documents.size());
+
+    std::vector<size_t> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    std::for_each(policy, chunks.begin(), chunks.end(), [&](const size_t chunk) {
+        PartialIndex& partial_index = partial_indexes[chunk];
+        try {
+            std::vector<std::string_view> words;
+            for (size_t i = chunk * chunk_size; i < std::min(documents.size(), (chunk + 1) * chunk_size); ++i) {
+                SplitIntoWordsNoStop(texts[i].text, words);
+                const double inv_word_count = 1.0 / words.size();
+                std::map<std::string_view, double> word_term_freqs;
+                documents_data[i] = std::make_shared<DocumentData>();
+                documents_data[i]->text = std::move(texts[i]);
+                for (const std::string_view word : words) {
+                    word_term_freqs[word] += inv_word_count;
+                    documents_data[i]->freq[word] = inv_word_count;
+                }
+                const DocumentOrdinal ordinal = static_cast<DocumentOrdinal>(i);
+                for (const auto& [word, term_freq] : word_term_freqs) {
+                    partial_index.word_postings[word].emplace_back(ordinal, term_freq);
+                }
+            }
+        }
+        catch (...) {
+            partial_index.error = std::current_exception();
+        }
+    });
+    for (const PartialIndex& partial_index : partial_indexes) {
+        if (partial_index.error) {
+            std::rethrow_exception(partial_index.error);
+        }
+    }
+
+    //     
+    std::shared_ptr<Segment> segment = MakeSegment();
+    auto terms = std::make_shared<TermDictionary>(term_pool_);
+    std::vector<size_t> term_sizes;
+    for (const PartialIndex& partial_index : partial_indexes) {
+        for (const auto& [word, postings] : partial_index.word_postings) {
+            const TermId term_id = terms->Intern(word);
+            if (term_id == term_sizes.size()) {
+                term_sizes.push_back(0);
+            }
+            term_sizes[term_id] += postings.size();
+        }
+    }
+    PostingsPacker postings_packer(term_sizes);
+    for (const PartialIndex& partial_index : partial_indexes) {
+        for (const auto& [word, postings] : partial_index.word_postings) {
+            const TermId term_id = terms->Find(word);
+            for (const auto& [ordinal, term_freq] : postings) {
+                postings_packer.Add(term_id, ordinal, term_freq);
+            }
+        }
+    }
+    segment->terms = std::move(terms);
+    segment->term_postings.resize(term_sizes.size());
+    segment->packed_postings = postings_packer.Finish();
+
+    std::vector<std::pair<int, DocumentOrdinal>> new_ordinals;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        new_ordinals.emplace_back(documents[i].id, static_cast<DocumentOrdinal>(i));
+        segment->ordinal_documents.push_back(std::move(documents_data[i]));
+        segment->ordinal_to_document_id.push_back(documents[i].id);
+        segment->ordinal_ratings.push_back(ComputeAverageRating(documents[i].ratings));
+        segment->ordinal_statuses.push_back(documents[i].status);
+    }
+    std::sort(new_ordinals.begin(), new_ordinals.end());
+    segment->AddDocumentIds(new_ordinals);
+    segment->is_sealed = true;
+
+    SealWriteBuffer(*index);
+    index->segments.push_back({ std::move(segment), nullptr });
+    index->document_count += documents.size();
+    ++index->generation;
+    index->document_ids = std::make_shared<DocumentIdList>();
+    UpdateLogTables(*index);
+    uint64_t log_sequence = 0;
+    for (const NewDocument& document : documents) {
+        log_sequence = LogAddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    PublishIndex(std::move(index));
+    RequestMerge();
+    guard.unlock();
+    WaitForOperationLog(log_sequence);
 }
 
 template <typename DocumentPredicate>
@@ -269,19 +1333,5 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
 
 template <typename ExecutionPolicy>
 void SearchServer::RemoveDocument(const ExecutionPolicy& policy, int document_id) {
-    if (!documents_.count(document_id)) {
-        return;
-    }
-    std::vector<const std::string*> temp(documents_[document_id].freq.size());
-
-    std::transform(policy, documents_[document_id].freq.begin(), documents_[document_id].freq.end(), temp.begin(), [](const std::pair<const std::string&, double> word_f) {
-        return &word_f.first;
-        });
-
-    std::for_each(policy, temp.begin(), temp.end(), [&](const std::string* word) {
-        word_to_document_freqs_.at(*word).erase(document_id); });
-
-    documents_.erase(document_id);
-    document_ids_.erase(find(document_ids_.begin(), document_ids_.end(), document_id));
+    RemoveDocument(document_id);
 }
-
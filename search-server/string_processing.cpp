@@ -1,5 +1,56 @@
 #include "string_processing.h"
 
+#include <bit>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t SCAN_BLOCK_SIZE = 64;
+
+//       :  i   i
+struct BlockMasks {
+    uint64_t spaces = 0;
+    uint64_t controls = 0;
+};
+
+BlockMasks ScanBlockScalar(const char* data, size_t size) {
+    BlockMasks masks;
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] == ' ') {
+            masks.spaces |= uint64_t{ 1 } << i;
+        }
+        else if (data[i] >= '\0' && data[i] < ' ') {
+            masks.controls |= uint64_t{ 1 } << i;
+        }
+    }
+    return masks;
+}
+
+BlockMasks ScanBlock(const char* data, size_t size) {
+#ifdef __SSE2__
+    if (size == SCAN_BLOCK_SIZE) {
+        const __m128i spaces = _mm_set1_epi8(' ');
+        const __m128i negative = _mm_set1_epi8(-1);
+        BlockMasks masks;
+        for (size_t i = 0; i < SCAN_BLOCK_SIZE; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            //   -   [0, 32)   
+            const __m128i controls = _mm_and_si128(_mm_cmpgt_epi8(spaces, bytes), _mm_cmpgt_epi8(bytes, negative));
+            masks.spaces |= uint64_t{ static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces))) } << i;
+            masks.controls |= uint64_t{ static_cast<uint16_t>(_mm_movemask_epi8(controls)) } << i;
+        }
+        return masks;
+    }
+#endif
+    return ScanBlockScalar(data, size);
+}
+
+}  // namespace
+
 std::vector<std::string> SplitIntoWords(const std::string& text) {
     std::vector<std::string> words;
     std::string word;
@@ -22,23 +73,50 @@ std::vector<std::string> SplitIntoWords(const std::string& text) {
 
 std::vector<std::string_view> SplitIntoWords(const std::string_view text) {
     std::vector<std::string_view> words;
-    
-    std::string_view delimiter = " ";
-    size_t first = 0;
-
-    while (first < text.size()) {
-        const auto second = text.find_first_of(delimiter, first);
+    SplitIntoWords(text, words);
+    return words;
+}
 
-        if (first != second) {
-            words.emplace_back(text.substr(first, second - first));
+size_t SplitIntoWords(const std::string_view text, std::vector<std::string_view>& words) {
+    words.clear();
+    size_t first_control = std::string_view::npos;
+    size_t word_begin = std::string_view::npos;
+    for (size_t block = 0; block < text.size(); block += SCAN_BLOCK_SIZE) {
+        const size_t size = std::min(SCAN_BLOCK_SIZE, text.size() - block);
+        const BlockMasks masks = ScanBlock(text.data() + block, size);
+        if (first_control == std::string_view::npos && masks.controls != 0) {
+            first_control = block + std::countr_zero(masks.controls);
         }
 
-        if (second == std::string_view::npos) {
-            break;
+        //     ,    
+        const uint64_t valid = size == SCAN_BLOCK_SIZE ? ~uint64_t{ 0 } : (uint64_t{ 1 } << size) - 1;
+        const uint64_t letters = ~masks.spaces & valid;
+        const uint64_t previous_letters = letters << 1 | (word_begin != std::string_view::npos ? 1 : 0);
+        const uint64_t starts = letters & ~previous_letters;
+        const uint64_t ends = ~letters & previous_letters & valid;
+        for (uint64_t bounds = starts | ends; bounds != 0; bounds &= bounds - 1) {
+            const size_t pos = block + std::countr_zero(bounds);
+            if (word_begin == std::string_view::npos) {
+                word_begin = pos;
+            }
+            else {
+                words.push_back(text.substr(word_begin, pos - word_begin));
+                word_begin = std::string_view::npos;
+            }
         }
+    }
+    if (word_begin != std::string_view::npos) {
+        words.push_back(text.substr(word_begin));
+    }
+    return first_control;
+}
 
-        first = second + 1;
+size_t FindControlChar(const std::string_view text) {
+    for (size_t block = 0; block < text.size(); block += SCAN_BLOCK_SIZE) {
+        const BlockMasks masks = ScanBlock(text.data() + block, std::min(SCAN_BLOCK_SIZE, text.size() - block));
+        if (masks.controls != 0) {
+            return block + std::countr_zero(masks.controls);
+        }
     }
-   
-    return words;
+    return std::string_view::npos;
 }
@@ -5,6 +5,7 @@
 #include <set>
 #include <map>
 #include <algorithm>
+#include <string_view>
 #include <utility>
 
 using namespace std::string_literals;
@@ -13,6 +14,13 @@ std::vector<std::string> SplitIntoWords(const std::string& text);
 
 std::vector<std::string_view> SplitIntoWords(const std::string_view text);
 
+//  text    words,    words .
+//      ( 0-31)  npos:
+//          .
+size_t SplitIntoWords(const std::string_view text, std::vector<std::string_view>& words);
+
+size_t FindControlChar(const std::string_view text);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
@@ -0,0 +1,150 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+TermDictionary::TermDictionary(std::shared_ptr<TermPool> term_pool)
+    : term_pool_(std::move(term_pool))
+{
+}
+
+TermDictionary::TermDictionary(std::span<const char> term_bytes, std::span<const uint64_t> term_offsets,
+    std::span<const size_t> term_hashes, std::span<const TermId> slots)
+    : mapped_term_bytes_(term_bytes)
+    , mapped_term_offsets_(term_offsets)
+    , mapped_term_hashes_(term_hashes)
+    , mapped_slots_(slots)
+{
+    const size_t term_count = term_hashes.size();
+    if (term_offsets.size() != term_count + 1 || term_offsets.back() > term_bytes.size()
+        || !std::is_sorted(term_offsets.begin(), term_offsets.end())
+        || (!slots.empty() && !std::has_single_bit(slots.size())) || slots.size() < term_count * 2) {
+        throw std::invalid_argument("Invalid term dictionary layout"s);
+    }
+    //      ,     
+    //          
+    std::vector<bool> is_placed(term_count, false);
+    for (const TermId term_id : slots) {
+        if (term_id == NO_TERM) {
+            continue;
+        }
+        if (term_id >= term_count || is_placed[term_id]) {
+            throw std::invalid_argument("Invalid term dictionary slots"s);
+        }
+        is_placed[term_id] = true;
+    }
+    if (std::find(is_placed.begin(), is_placed.end(), false) != is_placed.end()) {
+        throw std::invalid_argument("Invalid term dictionary slots"s);
+    }
+    for (const TermId term_id : { TermId{ 0 }, static_cast<TermId>(term_count - 1) }) {
+        if (term_count > 0 && Hash(GetTermUnchecked(term_id)) != term_hashes[term_id]) {
+            throw std::invalid_argument("Term dictionary was built with a different hash function"s);
+        }
+    }
+}
+
+TermDictionary::TermId TermDictionary::Intern(const std::string_view term) {
+    Materialize();
+    if ((terms_.size() + 1) * 2 > slots_.size()) {
+        Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+    }
+    const size_t hash = Hash(term);
+    const size_t slot = FindSlot(term, hash);
+    if (slots_[slot] != NO_TERM) {
+        return slots_[slot];
+    }
+    const TermId term_id = static_cast<TermId>(terms_.size());
+    terms_.push_back(term_pool_->Intern(term));
+    term_hashes_.push_back(hash);
+    slots_[slot] = term_id;
+    return term_id;
+}
+
+TermDictionary::TermId TermDictionary::Find(const std::string_view term) const {
+    const std::span<const TermId> slots = GetSlots();
+    if (slots.empty()) {
+        return NO_TERM;
+    }
+    return slots[FindSlot(term, Hash(term))];
+}
+
+std::string_view TermDictionary::GetTerm(TermId term_id) const {
+    if (term_id >= size()) {
+        throw std::out_of_range("Invalid term id"s);
+    }
+    return GetTermUnchecked(term_id);
+}
+
+size_t TermDictionary::size() const {
+    return IsMapped() ? mapped_term_hashes_.size() : terms_.size();
+}
+
+size_t TermDictionary::GetTermHash(TermId term_id) const {
+    return IsMapped() ? mapped_term_hashes_[term_id] : term_hashes_[term_id];
+}
+
+std::span<const TermDictionary::TermId> TermDictionary::GetSlots() const {
+    return IsMapped() ? mapped_slots_ : std::span<const TermId>(slots_);
+}
+
+bool TermDictionary::IsMapped() const {
+    return !mapped_term_offsets_.empty();
+}
+
+std::string_view TermDictionary::GetTermUnchecked(TermId term_id) const {
+    if (IsMapped()) {
+        return std::string_view(mapped_term_bytes_.data() + mapped_term_offsets_[term_id],
+            mapped_term_offsets_[term_id + 1] - mapped_term_offsets_[term_id]);
+    }
+    return terms_[term_id];
+}
+
+void TermDictionary::Materialize() {
+    if (!IsMapped()) {
+        return;
+    }
+    terms_.reserve(mapped_term_hashes_.size());
+    for (TermId term_id = 0; term_id < mapped_term_hashes_.size(); ++term_id) {
+        terms_.push_back(GetTermUnchecked(term_id));
+    }
+    term_hashes_.assign(mapped_term_hashes_.begin(), mapped_term_hashes_.end());
+    slots_.assign(mapped_slots_.begin(), mapped_slots_.end());
+    mapped_term_bytes_ = {};
+    mapped_term_offsets_ = {};
+    mapped_term_hashes_ = {};
+    mapped_slots_ = {};
+}
+
+size_t TermDictionary::Hash(const std::string_view term) {
+    return std::hash<std::string_view>{}(term);
+}
+
+size_t TermDictionary::FindSlot(const std::string_view term, size_t hash) const {
+    const std::span<const TermId> slots = GetSlots();
+    const size_t mask = slots.size() - 1;
+    size_t slot = hash & mask;
+    while (slots[slot] != NO_TERM) {
+        const TermId term_id = slots[slot];
+        if (GetTermHash(term_id) == hash && GetTermUnchecked(term_id) == term) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void TermDictionary::Rehash(size_t slot_count) {
+    slots_.assign(slot_count, NO_TERM);
+    const size_t mask = slot_count - 1;
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+        size_t slot = term_hashes_[term_id] & mask;
+        while (slots_[slot] != NO_TERM) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = term_id;
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "term_pool.h"
+
+class TermDictionary {
+public:
+    using TermId = uint32_t;
+
+    static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+    TermDictionary() = default;
+
+    //      term_pool,    
+    explicit TermDictionary(std::shared_ptr<TermPool> term_pool);
+
+    //    : term_offsets     term_bytes,
+    // term_hashes  slots  ,    GetTermHash  GetSlots.
+    TermDictionary(std::span<const char> term_bytes, std::span<const uint64_t> term_offsets,
+        std::span<const size_t> term_hashes, std::span<const TermId> slots);
+
+    TermId Intern(const std::string_view term);
+
+    TermId Find(const std::string_view term) const;
+
+    std::string_view GetTerm(TermId term_id) const;
+
+    size_t size() const;
+
+    size_t GetTermHash(TermId term_id) const;
+
+    std::span<const TermId> GetSlots() const;
+
+private:
+    std::shared_ptr<TermPool> term_pool_ = std::make_shared<TermPool>();
+    std::vector<std::string_view> terms_;
+    std::vector<size_t> term_hashes_;
+    std::vector<TermId> slots_;
+    std::span<const char> mapped_term_bytes_;
+    std::span<const uint64_t> mapped_term_offsets_;
+    std::span<const size_t> mapped_term_hashes_;
+    std::span<const TermId> mapped_slots_;
+
+    bool IsMapped() const;
+
+    std::string_view GetTermUnchecked(TermId term_id) const;
+
+    void Materialize();
+
+    static size_t Hash(const std::string_view term);
+
+    size_t FindSlot(const std::string_view term, size_t hash) const;
+
+    void Rehash(size_t slot_count);
+};
@@ -0,0 +1,14 @@
+#include "term_pool.h"
+
+std::string_view TermPool::Intern(const std::string_view term) {
+    std::lock_guard guard(mutex_);
+    if (const auto it = terms_.find(term); it != terms_.end()) {
+        return *it;
+    }
+    TextArena::StoredText stored_term = storage_.Store(term);
+    if (chunks_.empty() || chunks_.back() != stored_term.chunk) {
+        chunks_.push_back(std::move(stored_term.chunk));
+    }
+    terms_.insert(stored_term.text);
+    return stored_term.text;
+}
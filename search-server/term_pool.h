@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "text_arena.h"
+
+//    .       
+// ,   ,     
+//       .      .
+class TermPool {
+public:
+    std::string_view Intern(const std::string_view term);
+
+private:
+    std::mutex mutex_;
+    std::unordered_set<std::string_view> terms_;
+    TextArena storage_;
+    std::vector<std::shared_ptr<const TextArena::Chunk>> chunks_;
+};
@@ -0,0 +1,49 @@
+#include "text_arena.h"
+
+#include <algorithm>
+
+TextArena::Chunk::Chunk(size_t capacity, std::shared_ptr<std::atomic<size_t>> allocated_bytes)
+    : data_(std::make_unique_for_overwrite<char[]>(capacity))
+    , capacity_(capacity)
+    , allocated_bytes_(std::move(allocated_bytes))
+{
+    *allocated_bytes_ += capacity_;
+}
+
+TextArena::Chunk::~Chunk() {
+    *allocated_bytes_ -= capacity_;
+}
+
+size_t TextArena::Chunk::capacity() const {
+    return capacity_;
+}
+
+TextArena::TextArena(size_t chunk_size)
+    : chunk_size_(chunk_size)
+{
+}
+
+TextArena::StoredText TextArena::Store(const std::string_view text) {
+    std::shared_ptr<Chunk> chunk;
+    if (text.size() > chunk_size_ / 4) {
+        chunk = std::make_shared<Chunk>(text.size(), allocated_bytes_);
+    }
+    else {
+        if (!active_chunk_ || active_chunk_->capacity_ - active_chunk_->used_ < text.size()) {
+            active_chunk_ = std::make_shared<Chunk>(chunk_size_, allocated_bytes_);
+        }
+        chunk = active_chunk_;
+    }
+    char* data = chunk->data_.get() + chunk->used_;
+    std::copy(text.begin(), text.end(), data);
+    chunk->used_ += text.size();
+    return { std::string_view(data, text.size()), std::move(chunk) };
+}
+
+bool TextArena::IsActiveChunk(const Chunk* chunk) const {
+    return chunk == active_chunk_.get();
+}
+
+size_t TextArena::GetAllocatedBytes() const {
+    return allocated_bytes_->load();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+class TextArena {
+public:
+    class Chunk {
+    public:
+        Chunk(size_t capacity, std::shared_ptr<std::atomic<size_t>> allocated_bytes);
+
+        Chunk(const Chunk&) = delete;
+        Chunk& operator=(const Chunk&) = delete;
+
+        ~Chunk();
+
+        size_t capacity() const;
+
+    private:
+        friend class TextArena;
+
+        std::unique_ptr<char[]> data_;
+        size_t capacity_;
+        size_t used_ = 0;
+        std::shared_ptr<std::atomic<size_t>> allocated_bytes_;
+    };
+
+    //  ,       StoredText
+    struct StoredText {
+        std::string_view text;
+        std::shared_ptr<const Chunk> chunk;
+    };
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit TextArena(size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    StoredText Store(const std::string_view text);
+
+    bool IsActiveChunk(const Chunk* chunk) const;
+
+    size_t GetAllocatedBytes() const;
+
+private:
+    size_t chunk_size_;
+    std::shared_ptr<std::atomic<size_t>> allocated_bytes_ = std::make_shared<std::atomic<size_t>>(0);
+    std::shared_ptr<Chunk> active_chunk_;
+};
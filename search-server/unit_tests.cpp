@@ -285,4 +285,1413 @@ void TestSearchServer() {
     std::cout << "Search server testing finished"s << std::endl;
 }
 
-*/
\ No newline at end of file
+*/
+
+#include "allocation_counter.h"
+#include "assert_for_server.h"
+#include "batch_executor.h"
+#include "benchmark.h"
+#include "index_file.h"
+#include "latency_histogram.h"
+#include "operation_log.h"
+#include "posting_list.h"
+#include "process_queries.h"
+#include "profiler.h"
+#include "query_metrics.h"
+#include "request_queue.h"
+#include "result_cache.h"
+#include "string_processing.h"
+#include "term_dictionary.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+std::string MakeTestPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / ("search_server_test_"s + name)).string();
+}
+
+//  ,          
+void AssertSameSearch(SearchServer& expected, SearchServer& actual, const std::vector<std::string>& queries) {
+    ASSERT_EQUAL(actual.GetDocumentCount(), expected.GetDocumentCount());
+    const std::vector<int> document_ids(expected.begin(), expected.end());
+    ASSERT(std::vector<int>(actual.begin(), actual.end()) == document_ids);
+    for (const std::string& query : queries) {
+        for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT,
+            DocumentStatus::BANNED, DocumentStatus::REMOVED }) {
+            const std::vector<Document> expected_documents = expected.FindTopDocuments(query, status);
+            const std::vector<Document> actual_documents = actual.FindTopDocuments(query, status);
+            ASSERT_EQUAL_HINT(actual_documents.size(), expected_documents.size(), query);
+            for (size_t i = 0; i < expected_documents.size(); ++i) {
+                ASSERT_EQUAL_HINT(actual_documents[i].id, expected_documents[i].id, query);
+                ASSERT_EQUAL_HINT(actual_documents[i].rating, expected_documents[i].rating, query);
+                ASSERT_HINT(std::abs(actual_documents[i].relevance - expected_documents[i].relevance) < INACCURACY, query);
+            }
+        }
+        for (const int document_id : document_ids) {
+            const auto [expected_words, expected_status] = expected.MatchDocument(query, document_id);
+            const auto [actual_words, actual_status] = actual.MatchDocument(query, document_id);
+            ASSERT(actual_words == expected_words);
+            ASSERT(actual_status == expected_status);
+        }
+    }
+    for (const int document_id : document_ids) {
+        ASSERT(actual.GetWordFrequencies(document_id) == expected.GetWordFrequencies(document_id));
+    }
+}
+
+const std::vector<std::string> STORAGE_TEST_QUERIES = {
+    "cat"s, "fluffy groomed cat"s, "dog -collar"s, "and"s, "evgeny starling -cat"s, "missing"s,
+};
+
+void RemoveLogFiles(const std::string& path) {
+    std::filesystem::remove(path);
+    std::filesystem::remove(OperationLog::GetRotatedPath(path));
+}
+
+//          
+void AssertSameDocuments(const SearchServer& expected, const SearchServer& actual, const std::string& query) {
+    const auto by_id = [](const Document& lhs, const Document& rhs) {
+        return lhs.id < rhs.id;
+    };
+    std::vector<Document> expected_documents = expected.FindTopDocuments(query);
+    std::vector<Document> actual_documents = actual.FindTopDocuments(query);
+    std::sort(expected_documents.begin(), expected_documents.end(), by_id);
+    std::sort(actual_documents.begin(), actual_documents.end(), by_id);
+    ASSERT_EQUAL_HINT(actual_documents.size(), expected_documents.size(), query);
+    for (size_t i = 0; i < expected_documents.size(); ++i) {
+        ASSERT_EQUAL_HINT(actual_documents[i].id, expected_documents[i].id, query);
+        ASSERT_EQUAL_HINT(actual_documents[i].rating, expected_documents[i].rating, query);
+        ASSERT_HINT(std::abs(actual_documents[i].relevance - expected_documents[i].relevance) < INACCURACY, query);
+    }
+}
+
+//      . IsMoreRelevant  
+//   INACCURACY,        
+//       .   ,  
+//        
+void AssertSameTopDocuments(const std::vector<Document>& expected, const std::vector<Document>& actual,
+    size_t max_document_count, const std::string& hint) {
+    ASSERT_EQUAL_HINT(actual.size(), expected.size(), hint);
+    if (expected.empty()) {
+        return;
+    }
+    double bound = -1.0;
+    if (expected.size() == max_document_count) {
+        const auto by_relevance = [](const Document& lhs, const Document& rhs) {
+            return lhs.relevance < rhs.relevance;
+        };
+        bound = std::max(std::min_element(expected.begin(), expected.end(), by_relevance)->relevance,
+            std::min_element(actual.begin(), actual.end(), by_relevance)->relevance) + INACCURACY;
+    }
+    std::map<int, Document> actual_documents;
+    for (const Document& document : actual) {
+        actual_documents[document.id] = document;
+    }
+    for (const Document& document : expected) {
+        const auto it = actual_documents.find(document.id);
+        if (it == actual_documents.end()) {
+            ASSERT_HINT(document.relevance < bound, hint);
+            continue;
+        }
+        ASSERT_EQUAL_HINT(it->second.rating, document.rating, hint);
+        ASSERT_HINT(std::abs(it->second.relevance - document.relevance) < INACCURACY, hint);
+        actual_documents.erase(it);
+    }
+    for (const auto& [document_id, document] : actual_documents) {
+        ASSERT_HINT(document.relevance < bound, hint);
+    }
+}
+
+std::optional<Profiler::ZoneStats> FindZoneStats(std::string_view name) {
+    for (Profiler::ZoneStats& stats : Profiler::GetStats()) {
+        if (stats.name == name) {
+            return std::move(stats);
+        }
+    }
+    return std::nullopt;
+}
+
+size_t CountOccurrences(std::string_view text, std::string_view pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string_view::npos; pos = text.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+}  // namespace
+
+void TestIndexFileRoundTrip() {
+    const std::string path = MakeTestPath("round_trip.index"s);
+    const std::string resaved_path = MakeTestPath("round_trip_resaved.index"s);
+    SearchServer server("and with"s);
+    server.SetMaxResultDocumentCount(3);
+    server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::BANNED, { 5, -12, 2, 1 });
+    server.AddDocument(4, "groomed starling evgeny"s, DocumentStatus::IRRELEVANT, { 9 });
+    server.AddDocuments(std::vector<NewDocument>{
+        { 5, "cat with dog and collar", DocumentStatus::ACTUAL, { 1 } },
+        { 6, "fluffy starling", DocumentStatus::REMOVED, { 4, 4 } },
+        { 7, "cat cat cat", DocumentStatus::ACTUAL, { -2 } },
+    });
+    server.RemoveDocument(2);
+    server.SaveIndex(path);
+
+    {
+        SearchServer loaded(IndexFile::Open(path));
+        ASSERT_EQUAL(loaded.GetMaxResultDocumentCount(), 3u);
+        AssertSameSearch(server, loaded, STORAGE_TEST_QUERIES);
+
+        //       
+        server.AddDocument(8, "groomed cat with collar"s, DocumentStatus::ACTUAL, { 3 });
+        loaded.AddDocument(8, "groomed cat with collar"s, DocumentStatus::ACTUAL, { 3 });
+        server.RemoveDocument(1);
+        loaded.RemoveDocument(1);
+        AssertSameSearch(server, loaded, STORAGE_TEST_QUERIES);
+        loaded.SaveIndex(resaved_path);
+    }
+    {
+        SearchServer reloaded(IndexFile::Open(resaved_path));
+        AssertSameSearch(server, reloaded, STORAGE_TEST_QUERIES);
+    }
+
+    //    
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    bool is_rejected = false;
+    try {
+        SearchServer truncated(IndexFile::Open(path));
+    }
+    catch (const std::exception&) {
+        is_rejected = true;
+    }
+    ASSERT(is_rejected);
+    std::filesystem::remove(path);
+    std::filesystem::remove(resaved_path);
+}
+
+void TestOperationLogReplay() {
+    const std::string path = MakeTestPath("replay.log"s);
+    RemoveLogFiles(path);
+    SearchServer expected("and with"s);
+    {
+        SearchServer server("and with"s);
+        server.OpenOperationLog(path);
+        for (SearchServer* target : { &server, &expected }) {
+            target->AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+            target->AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+            target->AddDocuments(std::vector<NewDocument>{
+                { 3, "groomed dog expressive eyes", DocumentStatus::BANNED, { 5, -12, 2, 1 } },
+                { 4, "groomed starling evgeny", DocumentStatus::IRRELEVANT, {} },
+            });
+            target->RemoveDocument(2);
+            target->AddDocument(5, "cat with dog and collar"s, DocumentStatus::ACTUAL, { 1 });
+        }
+    }
+    {
+        SearchServer recovered("and with"s);
+        recovered.OpenOperationLog(path);
+        AssertSameSearch(expected, recovered, STORAGE_TEST_QUERIES);
+
+        //      
+        recovered.AddDocument(6, "fluffy starling"s, DocumentStatus::REMOVED, { 4 });
+        expected.AddDocument(6, "fluffy starling"s, DocumentStatus::REMOVED, { 4 });
+        recovered.RemoveDocument(3);
+        expected.RemoveDocument(3);
+    }
+    {
+        SearchServer recovered("and with"s);
+        recovered.OpenOperationLog(path);
+        AssertSameSearch(expected, recovered, STORAGE_TEST_QUERIES);
+    }
+    RemoveLogFiles(path);
+}
+
+void TestOperationLogTruncatedTail() {
+    const std::string path = MakeTestPath("truncated.log"s);
+    RemoveLogFiles(path);
+    {
+        SearchServer server("and with"s);
+        server.OpenOperationLog(path);
+        server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8 });
+        server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7 });
+        server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5 });
+    }
+    ASSERT_EQUAL(OperationLog::ReadRecords(path).size(), 3u);
+
+    //     
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+    size_t valid_size = 0;
+    const std::vector<OperationLog::Record> records = OperationLog::ReadRecords(path, &valid_size);
+    ASSERT_EQUAL(records.size(), 2u);
+    ASSERT_EQUAL(records[1].document_id, 2);
+    ASSERT_EQUAL(records[1].text, "fluffy cat fluffy tail"s);
+    ASSERT(records[1].ratings == std::vector<int>{ 7 });
+    ASSERT(valid_size < std::filesystem::file_size(path));
+    {
+        SearchServer recovered("and with"s);
+        recovered.OpenOperationLog(path);
+        ASSERT_EQUAL(recovered.GetDocumentCount(), 2);
+        ASSERT(recovered.FindTopDocuments("groomed"s).empty());
+        //  ,      
+        recovered.AddDocument(4, "groomed starling evgeny"s, DocumentStatus::ACTUAL, { 9 });
+    }
+    ASSERT_EQUAL(OperationLog::ReadRecords(path).size(), 3u);
+    {
+        SearchServer recovered("and with"s);
+        recovered.OpenOperationLog(path);
+        ASSERT_EQUAL(recovered.GetDocumentCount(), 3);
+        ASSERT_EQUAL(recovered.FindTopDocuments("groomed"s).size(), 1u);
+    }
+
+    //           
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(std::filesystem::file_size(path) / 2));
+        file.put('#');
+    }
+    ASSERT(OperationLog::ReadRecords(path).size() < 3u);
+    RemoveLogFiles(path);
+}
+
+void TestCheckpointRecovery() {
+    const std::string path = MakeTestPath("checkpoint.log"s);
+    const std::string index_path = MakeTestPath("checkpoint.index"s);
+    const std::string stale_log_path = MakeTestPath("checkpoint_stale.log"s);
+    RemoveLogFiles(path);
+    SearchServer expected("and with"s);
+    {
+        SearchServer server("and with"s);
+        server.OpenOperationLog(path);
+        for (SearchServer* target : { &server, &expected }) {
+            target->AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+            target->AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+            target->AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::BANNED, { 5 });
+        }
+        std::filesystem::copy_file(path, stale_log_path, std::filesystem::copy_options::overwrite_existing);
+        server.Checkpoint(index_path);
+        ASSERT(!std::filesystem::exists(OperationLog::GetRotatedPath(path)));
+        ASSERT(OperationLog::ReadRecords(path).empty());
+        for (SearchServer* target : { &server, &expected }) {
+            target->AddDocument(4, "groomed starling evgeny"s, DocumentStatus::IRRELEVANT, { 9 });
+            target->RemoveDocument(1);
+        }
+    }
+    {
+        SearchServer recovered(IndexFile::Open(index_path));
+        recovered.OpenOperationLog(path);
+        AssertSameSearch(expected, recovered, STORAGE_TEST_QUERIES);
+    }
+
+    //    ,     :
+    // ,    ,   
+    std::filesystem::copy_file(stale_log_path, OperationLog::GetRotatedPath(path));
+    {
+        SearchServer recovered(IndexFile::Open(index_path));
+        recovered.OpenOperationLog(path);
+        AssertSameSearch(expected, recovered, STORAGE_TEST_QUERIES);
+    }
+
+    //    :      
+    {
+        SearchServer recovered("and with"s);
+        recovered.OpenOperationLog(path);
+        AssertSameSearch(expected, recovered, STORAGE_TEST_QUERIES);
+    }
+    RemoveLogFiles(path);
+    std::filesystem::remove(index_path);
+    std::filesystem::remove(stale_log_path);
+}
+
+void TestReAddRemovedDocument() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    server.RemoveDocument(1);
+    server.AddDocument(1, "fluffy cat"s, DocumentStatus::BANNED, { 5 });
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+    ASSERT(std::get<1>(server.MatchDocument("fluffy"s, 1)) == DocumentStatus::BANNED);
+    ASSERT(std::get<0>(server.MatchDocument("fluffy"s, 1)) == std::vector<std::string_view>{ std::string_view("fluffy") });
+    ASSERT_EQUAL(server.GetWordFrequencies(1).size(), 2u);
+    ASSERT_EQUAL(server.GetWordFrequencies(1).count(std::string_view("fluffy")), 1u);
+
+    bool is_rejected = false;
+    try {
+        server.AddDocument(1, "groomed cat"s, DocumentStatus::ACTUAL, { 2 });
+    }
+    catch (const std::invalid_argument&) {
+        is_rejected = true;
+    }
+    ASSERT(is_rejected);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s, DocumentStatus::BANNED).size(), 1u);
+    ASSERT(server.FindTopDocuments("cat"s).empty());
+
+    server.RemoveDocument(1);
+    ASSERT_EQUAL(server.GetDocumentCount(), 0);
+    ASSERT(server.FindTopDocuments("cat"s, DocumentStatus::BANNED).empty());
+    ASSERT(server.GetWordFrequencies(1).empty());
+
+    //   id    
+    server.AddDocument(1, "groomed dog"s, DocumentStatus::ACTUAL, { 3 });
+    ASSERT_EQUAL(server.GetDocumentCount(), 1);
+    ASSERT(std::vector<int>(server.begin(), server.end()) == std::vector<int>{ 1 });
+    ASSERT_EQUAL(server.FindTopDocuments("dog"s).size(), 1u);
+    ASSERT(server.FindTopDocuments("cat"s).empty());
+    ASSERT(std::get<0>(server.MatchDocument("groomed cat"s, 1)) == std::vector<std::string_view>{ std::string_view("groomed") });
+}
+
+void TestSegmentMergeWithTombstones() {
+    const std::string path = MakeTestPath("tombstones.index"s);
+    const int document_count = 3000;
+    const auto make_text = [](int document_id) {
+        return "cat"s + (document_id % 3 == 0 ? " dog"s : ""s) + " tag"s + std::to_string(document_id % 17);
+    };
+    const std::vector<std::string> queries = { "cat"s, "dog"s, "fresh"s, "tag3 -dog"s, "fresh tag5 -cat"s };
+
+    SearchServer server("and with"s);
+    SearchServer expected("and with"s);
+    server.SetMaxResultDocumentCount(document_count);
+    expected.SetMaxResultDocumentCount(document_count);
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        server.AddDocument(document_id, make_text(document_id), DocumentStatus::ACTUAL, { document_id % 5 });
+        //   ,      
+        if (document_id % 10 == 0) {
+            server.RemoveDocument(document_id);
+            server.AddDocument(document_id, make_text(document_id) + " fresh"s, DocumentStatus::ACTUAL, { 1 });
+        }
+    }
+    //        
+    for (int document_id = 0; document_id < document_count; document_id += 4) {
+        if (document_id % 10 != 0) {
+            server.RemoveDocument(document_id);
+            server.AddDocument(document_id, make_text(document_id) + " fresh"s, DocumentStatus::ACTUAL, { 1 });
+        }
+    }
+    for (int document_id = 1; document_id < document_count; document_id += 7) {
+        server.RemoveDocument(document_id);
+    }
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        if (document_id % 7 == 1) {
+            continue;
+        }
+        if (document_id % 10 == 0 || document_id % 4 == 0) {
+            expected.AddDocument(document_id, make_text(document_id) + " fresh"s, DocumentStatus::ACTUAL, { 1 });
+        }
+        else {
+            expected.AddDocument(document_id, make_text(document_id), DocumentStatus::ACTUAL, { document_id % 5 });
+        }
+    }
+
+    ASSERT_EQUAL(server.GetDocumentCount(), expected.GetDocumentCount());
+    ASSERT(std::vector<int>(server.begin(), server.end()) == std::vector<int>(expected.begin(), expected.end()));
+    for (const std::string& query : queries) {
+        AssertSameDocuments(expected, server, query);
+    }
+
+    // SaveIndex   ,   
+    server.SaveIndex(path);
+    {
+        SearchServer loaded(IndexFile::Open(path));
+        ASSERT_EQUAL(loaded.GetDocumentCount(), expected.GetDocumentCount());
+        for (const std::string& query : queries) {
+            AssertSameDocuments(expected, loaded, query);
+        }
+        for (int document_id = 2; document_id < document_count; document_id += 100) {
+            loaded.RemoveDocument(document_id);
+            loaded.AddDocument(document_id, "replaced"s, DocumentStatus::ACTUAL, { 2 });
+            expected.RemoveDocument(document_id);
+            expected.AddDocument(document_id, "replaced"s, DocumentStatus::ACTUAL, { 2 });
+        }
+        ASSERT_EQUAL(loaded.GetDocumentCount(), expected.GetDocumentCount());
+        AssertSameDocuments(expected, loaded, "replaced"s);
+        for (const std::string& query : queries) {
+            AssertSameDocuments(expected, loaded, query);
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+void TestPostingBlockDecoding() {
+    std::mt19937 generator(42);
+    std::vector<double> term_freq_table(300);
+    for (size_t code = 0; code < term_freq_table.size(); ++code) {
+        term_freq_table[code] = 1.0 / static_cast<double>(code + 1);
+    }
+    std::vector<bool> decoding_modes = { false };
+    if (PostingList::IsVectorDecodingSupported()) {
+        decoding_modes.push_back(true);
+    }
+
+    for (const size_t size : { 1, 7, 8, 127, 128, 129, 1000 }) {
+        //  ,    25 ,     
+        for (const uint32_t requested_max_gap : { 0u, 3u, 1000u, 1u << 30 }) {
+            const uint32_t max_gap = std::min<uint32_t>(requested_max_gap, (UINT32_MAX - 200) / size - 1);
+            //      
+            for (const uint32_t code_count : { 1u, 5u, 300u }) {
+                std::vector<DocumentOrdinal> ordinals;
+                std::vector<uint32_t> codes;
+                DocumentOrdinal ordinal = std::uniform_int_distribution<DocumentOrdinal>(0, 100)(generator);
+                for (size_t i = 0; i < size; ++i) {
+                    ordinals.push_back(ordinal);
+                    codes.push_back(std::uniform_int_distribution<uint32_t>(0, code_count - 1)(generator));
+                    ordinal += 1 + std::uniform_int_distribution<uint32_t>(0, max_gap)(generator);
+                }
+                std::vector<uint8_t> block_data;
+                std::vector<PostingBlockHeader> blocks;
+                PostingList::EncodeBlocks(ordinals, codes, block_data, blocks);
+                block_data.resize(block_data.size() + PostingList::BLOCK_PADDING);
+                const PostingList postings(blocks, block_data.data(), term_freq_table.data(), size, 1.0);
+                ASSERT_EQUAL(postings.size(), size);
+                ASSERT_EQUAL(postings.GetBlockCount(), (size + PostingList::BLOCK_SIZE - 1) / PostingList::BLOCK_SIZE);
+
+                for (const bool is_vector_decoding : decoding_modes) {
+                    PostingList::SetVectorDecoding(is_vector_decoding);
+                    const std::string hint = "size "s + std::to_string(size) + ", gap "s + std::to_string(max_gap)
+                        + ", codes "s + std::to_string(code_count) + (is_vector_decoding ? ", vector"s : ", scalar"s);
+                    PostingList::BlockBuffer buffer;
+                    for (size_t block = 0; block < postings.GetBlockCount(); ++block) {
+                        const PostingList::Block decoded = postings.GetBlock(block, buffer);
+                        const size_t first = block * PostingList::BLOCK_SIZE;
+                        ASSERT_EQUAL_HINT(decoded.ordinals.size(), std::min(PostingList::BLOCK_SIZE, size - first), hint);
+                        for (size_t i = 0; i < decoded.ordinals.size(); ++i) {
+                            ASSERT_EQUAL_HINT(decoded.ordinals[i], ordinals[first + i], hint);
+                            ASSERT_EQUAL_HINT(decoded.term_freqs[i], term_freq_table[codes[first + i]], hint);
+                        }
+                        ASSERT_EQUAL_HINT(postings.GetBlockLastOrdinal(block), decoded.ordinals.back(), hint);
+                        ASSERT_EQUAL_HINT(postings.FindBlock(decoded.ordinals.front()), block, hint);
+                    }
+
+                    size_t visited = 0;
+                    const DocumentOrdinal first_ordinal = ordinals[size / 3];
+                    const DocumentOrdinal last_ordinal = ordinals[size - 1 - size / 3];
+                    postings.ForEach(first_ordinal, last_ordinal, [&](DocumentOrdinal ordinal, double term_freq) {
+                        ASSERT_EQUAL_HINT(ordinal, ordinals[size / 3 + visited], hint);
+                        ASSERT_EQUAL_HINT(term_freq, term_freq_table[codes[size / 3 + visited]], hint);
+                        ++visited;
+                        });
+                    ASSERT_EQUAL_HINT(visited, static_cast<size_t>(size - 1 - size / 3 - size / 3), hint);
+
+                    for (size_t i = 0; i < size; i += 13) {
+                        ASSERT_HINT(postings.Contains(ordinals[i]), hint);
+                        const bool is_next_taken = i + 1 < size && ordinals[i + 1] == ordinals[i] + 1;
+                        ASSERT_EQUAL_HINT(postings.Contains(ordinals[i] + 1), is_next_taken, hint);
+                    }
+                }
+            }
+        }
+    }
+    PostingList::SetVectorDecoding(true);
+}
+
+void TestCompressedSegmentSearch() {
+    const int document_count = 2500;
+    const std::vector<std::string> words = { "cat"s, "dog"s, "fluffy"s, "groomed"s, "collar"s, "tail"s, "eyes"s,
+        "starling"s, "white"s, "fashionable"s };
+    std::mt19937 generator(7);
+    std::vector<std::string> texts;
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        std::string text;
+        const int word_count = std::uniform_int_distribution<int>(1, 12)(generator);
+        for (int i = 0; i < word_count; ++i) {
+            //     ,   
+            const size_t word = std::min(std::geometric_distribution<size_t>(0.3)(generator), words.size() - 1);
+            text += words[word] + " "s;
+        }
+        texts.push_back(std::move(text));
+    }
+
+    //     ,      
+    SearchServer compressed("and with"s);
+    SearchServer plain("and with"s);
+    compressed.SetMaxResultDocumentCount(document_count);
+    plain.SetMaxResultDocumentCount(document_count);
+    std::vector<NewDocument> documents;
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        documents.push_back({ document_id, texts[document_id], DocumentStatus::ACTUAL, { document_id % 11 } });
+        plain.AddDocument(document_id, texts[document_id], DocumentStatus::ACTUAL, { document_id % 11 });
+    }
+    compressed.AddDocuments(documents);
+
+    const std::vector<std::string> queries = { "cat"s, "starling fashionable"s, "dog tail -cat"s,
+        "white eyes collar -fluffy -groomed"s, "fashionable -white"s };
+    for (const bool is_vector_decoding : { false, true }) {
+        PostingList::SetVectorDecoding(is_vector_decoding);
+        for (const std::string& query : queries) {
+            AssertSameDocuments(plain, compressed, query);
+        }
+    }
+    PostingList::SetVectorDecoding(true);
+}
+
+void TestQueryContextAllocations() {
+    CorpusOptions options;
+    options.document_count = 5000;
+    options.query_count = 1000;
+    options.minus_word_ratio = 0.3;
+    const Corpus corpus = GenerateCorpus(options);
+
+    //    ,      
+    SearchServer server(corpus.stop_words);
+    std::vector<NewDocument> documents;
+    for (int document_id = 0; document_id < 4000; ++document_id) {
+        documents.push_back({ document_id, corpus.documents[document_id], DocumentStatus::ACTUAL, { document_id % 5 } });
+    }
+    server.AddDocuments(documents);
+    for (int document_id = 4000; document_id < options.document_count; ++document_id) {
+        server.AddDocument(document_id, corpus.documents[document_id], DocumentStatus::ACTUAL, { document_id % 5 });
+    }
+    for (int document_id = 0; document_id < options.document_count; document_id += 9) {
+        server.RemoveDocument(document_id);
+    }
+
+    //          
+    SearchServer::QueryContext context;
+    for (const std::string& query : corpus.queries) {
+        server.FindTopDocuments(context, std::execution::seq, query);
+    }
+    const size_t first_allocation_count = GetThreadAllocationCount();
+    size_t document_count = 0;
+    for (const std::string& query : corpus.queries) {
+        document_count += server.FindTopDocuments(context, std::execution::seq, query).size();
+    }
+    //    :   ASSERT    
+    const size_t query_allocation_count = GetThreadAllocationCount() - first_allocation_count;
+    ASSERT_EQUAL(query_allocation_count, 0u);
+    ASSERT(document_count > 0);
+}
+
+void TestMappedTermDictionaryValidation() {
+    TermDictionary dictionary;
+    std::string term_bytes;
+    std::vector<uint64_t> term_offsets = { 0 };
+    std::vector<size_t> term_hashes;
+    for (int i = 0; i < 20; ++i) {
+        const std::string term = "term"s + std::to_string(i);
+        const TermDictionary::TermId term_id = dictionary.Intern(term);
+        term_bytes += term;
+        term_offsets.push_back(term_bytes.size());
+        term_hashes.push_back(dictionary.GetTermHash(term_id));
+    }
+    const std::vector<TermDictionary::TermId> slots(dictionary.GetSlots().begin(), dictionary.GetSlots().end());
+
+    const auto is_rejected = [&](const std::vector<uint64_t>& offsets, const std::vector<TermDictionary::TermId>& table) {
+        try {
+            TermDictionary mapped(std::span<const char>(term_bytes), offsets, term_hashes, table);
+        }
+        catch (const std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    ASSERT(!is_rejected(term_offsets, slots));
+    const TermDictionary mapped(std::span<const char>(term_bytes), term_offsets, term_hashes, slots);
+    ASSERT_EQUAL(mapped.Find("term7"s), dictionary.Find("term7"s));
+    ASSERT_EQUAL(mapped.Find("missing"s), TermDictionary::NO_TERM);
+
+    const auto occupied = std::find_if(slots.begin(), slots.end(), [](TermDictionary::TermId term_id) {
+        return term_id != TermDictionary::NO_TERM;
+    }) - slots.begin();
+    const auto empty = std::find(slots.begin(), slots.end(), TermDictionary::NO_TERM) - slots.begin();
+
+    //     
+    std::vector<TermDictionary::TermId> corrupt_slots = slots;
+    corrupt_slots[occupied] = 20;
+    ASSERT(is_rejected(term_offsets, corrupt_slots));
+    //    
+    corrupt_slots = slots;
+    corrupt_slots[empty] = slots[occupied];
+    ASSERT(is_rejected(term_offsets, corrupt_slots));
+    //    
+    corrupt_slots = slots;
+    corrupt_slots[occupied] = TermDictionary::NO_TERM;
+    ASSERT(is_rejected(term_offsets, corrupt_slots));
+    //         
+    corrupt_slots.assign(slots.size(), 0);
+    std::iota(corrupt_slots.begin(), corrupt_slots.begin() + 20, 0);
+    ASSERT(is_rejected(term_offsets, corrupt_slots));
+    //     
+    corrupt_slots = slots;
+    corrupt_slots.push_back(TermDictionary::NO_TERM);
+    ASSERT(is_rejected(term_offsets, corrupt_slots));
+    //         
+    std::vector<uint64_t> corrupt_offsets = term_offsets;
+    std::swap(corrupt_offsets[3], corrupt_offsets[4]);
+    ASSERT(is_rejected(corrupt_offsets, slots));
+    corrupt_offsets = term_offsets;
+    corrupt_offsets.back() = term_bytes.size() + 1;
+    ASSERT(is_rejected(corrupt_offsets, slots));
+    corrupt_offsets.pop_back();
+    ASSERT(is_rejected(corrupt_offsets, slots));
+}
+
+void TestIndexStorage() {
+    RUN_TEST(TestIndexFileRoundTrip);
+    RUN_TEST(TestOperationLogReplay);
+    RUN_TEST(TestOperationLogTruncatedTail);
+    RUN_TEST(TestCheckpointRecovery);
+    RUN_TEST(TestReAddRemovedDocument);
+    RUN_TEST(TestSegmentMergeWithTombstones);
+    RUN_TEST(TestPostingBlockDecoding);
+    RUN_TEST(TestCompressedSegmentSearch);
+    RUN_TEST(TestQueryContextAllocations);
+    RUN_TEST(TestMappedTermDictionaryValidation);
+    std::cout << "Index storage testing finished"s << std::endl;
+}
+
+void TestPrunedSearchMatchesExhaustive() {
+    for (const double zipf_skew : { 0.8, 1.2 }) {
+        CorpusOptions options;
+        options.document_count = 20000;
+        options.query_count = 200;
+        options.zipf_skew = zipf_skew;
+        options.minus_word_ratio = 0.2;
+        options.seed = static_cast<uint32_t>(zipf_skew * 10);
+        const Corpus corpus = GenerateCorpus(options);
+
+        SearchServer server(corpus.stop_words);
+        const auto get_status = [](int document_id) {
+            return document_id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        };
+        std::vector<NewDocument> documents;
+        for (int document_id = 0; document_id < 15000; ++document_id) {
+            documents.push_back({ document_id, corpus.documents[document_id], get_status(document_id),
+                { document_id % 11 - 5 } });
+        }
+        server.AddDocuments(documents);
+        for (int document_id = 15000; document_id < options.document_count; ++document_id) {
+            server.AddDocument(document_id, corpus.documents[document_id], get_status(document_id),
+                { document_id % 11 - 5 });
+        }
+        for (int document_id = 3; document_id < options.document_count; document_id += 10) {
+            server.RemoveDocument(document_id);
+        }
+
+        for (const size_t max_document_count : { 1u, 5u, 50u }) {
+            server.SetMaxResultDocumentCount(max_document_count);
+            for (const std::string& query : corpus.queries) {
+                for (const DocumentStatus status : { DocumentStatus::ACTUAL, DocumentStatus::BANNED }) {
+                    AssertSameTopDocuments(server.FindTopDocuments(std::execution::par, query, status),
+                        server.FindTopDocuments(std::execution::seq, query, status), max_document_count, query);
+                }
+            }
+            const std::vector<std::vector<Document>> processed = ProcessQueries(server, corpus.queries);
+            for (size_t i = 0; i < corpus.queries.size(); ++i) {
+                AssertSameTopDocuments(server.FindTopDocuments(std::execution::par, corpus.queries[i]), processed[i],
+                    max_document_count, corpus.queries[i]);
+            }
+        }
+    }
+}
+
+void TestReadsDuringWrites() {
+    const auto make_text = [](int document_id) {
+        return "white"s + std::to_string(document_id % 10) + " cat"s + std::to_string(document_id % 3) + " collar"s;
+    };
+    SearchServer server("and with"s);
+    for (int document_id = 0; document_id < 100; ++document_id) {
+        server.AddDocument(document_id, make_text(document_id), DocumentStatus::ACTUAL, { document_id % 5 });
+    }
+
+    std::atomic<bool> is_writing = true;
+    std::thread writer([&] {
+        int next_document_id = 100;
+        for (int round = 0; round < 20; ++round) {
+            //         
+            std::vector<std::string> texts;
+            std::vector<NewDocument> documents;
+            for (int i = 0; i < 1100; ++i) {
+                texts.push_back(make_text(next_document_id + i));
+            }
+            for (const std::string& text : texts) {
+                documents.push_back({ next_document_id++, text, DocumentStatus::ACTUAL, { 1 } });
+            }
+            server.AddDocuments(documents);
+            for (int document_id = next_document_id - 1100; document_id < next_document_id; document_id += 2) {
+                server.RemoveDocument(document_id);
+            }
+            server.AddDocument(next_document_id, make_text(next_document_id), DocumentStatus::ACTUAL, { 2 });
+            ++next_document_id;
+            server.CompactStorage();
+        }
+        is_writing = false;
+        });
+
+    int pass_count = 0;
+    while (is_writing || pass_count == 0) {
+        int previous_document_id = -1;
+        size_t document_count = 0;
+        for (const int document_id : server) {
+            ASSERT(document_id > previous_document_id);
+            previous_document_id = document_id;
+            ++document_count;
+            if (document_id % 97 != 0) {
+                continue;
+            }
+            //       begin():   
+            const SearchServer::WordFrequencies word_frequencies = server.GetWordFrequencies(document_id);
+            ASSERT(word_frequencies.empty() || word_frequencies.size() == 3u);
+            for (const auto& [word, term_freq] : word_frequencies) {
+                ASSERT(word == "white"s + std::to_string(document_id % 10) || word == "collar"s
+                    || word == "cat"s + std::to_string(document_id % 3));
+                ASSERT(std::abs(term_freq - 1.0 / 3) < INACCURACY);
+            }
+        }
+        ASSERT(document_count >= 100u);
+        for (const Document& document : server.FindTopDocuments("white7 -cat1"s)) {
+            ASSERT_EQUAL(document.id % 10, 7);
+            ASSERT(document.id % 3 != 1);
+        }
+        ++pass_count;
+    }
+    writer.join();
+
+    // ,   ,     
+    const SearchServer::DocumentIdIterator first = server.begin();
+    const std::vector<int> document_ids(first, server.end());
+    server.RemoveDocument(document_ids.front());
+    server.AddDocument(1'000'000, make_text(0), DocumentStatus::ACTUAL, { 1 });
+    server.CompactStorage();
+    ASSERT(std::vector<int>(first, server.end()) == document_ids);
+    ASSERT_EQUAL(std::vector<int>(server.begin(), server.end()).size(), document_ids.size());
+}
+
+void TestCompactStorage() {
+    //      ,      
+    std::mt19937 generator(17);
+    std::vector<std::string> texts;
+    for (int document_id = 0; document_id < 1000; ++document_id) {
+        std::string text;
+        for (int i = 0; i < 30; ++i) {
+            text += "word"s + std::to_string(generator() % 40) + " "s;
+        }
+        texts.push_back(text + "collar"s);
+    }
+    SearchServer server("and with"s);
+    SearchServer expected("and with"s);
+    for (int document_id = 0; document_id < 1000; ++document_id) {
+        const DocumentStatus status = document_id % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        server.AddDocument(document_id, texts[document_id], status, { document_id % 7 });
+        if (document_id % 10 == 0) {
+            expected.AddDocument(document_id, texts[document_id], status, { document_id % 7 });
+        }
+        else {
+            server.RemoveDocument(document_id);
+        }
+    }
+    const std::vector<std::string> queries = { "word1 word2"s, "word7 -word3"s, "collar"s, "word39 word0 -collar"s };
+    AssertSameSearch(expected, server, queries);
+
+    const size_t storage_size = server.GetStorageSize();
+    {
+        const SearchServer::WordFrequencies word_frequencies = server.GetWordFrequencies(10);
+        const std::map<std::string_view, double> expected_word_frequencies = word_frequencies.Get();
+        server.CompactStorage();
+        AssertSameSearch(expected, server, queries);
+        // ,   ,      
+        ASSERT(word_frequencies.Get() == expected_word_frequencies);
+    }
+
+    //          
+    for (int attempt = 0; attempt < 100 && server.GetStorageSize() >= storage_size / 2; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_HINT(server.GetStorageSize() < storage_size / 2,
+        std::to_string(server.GetStorageSize()) + " of "s + std::to_string(storage_size));
+}
+
+void TestBlockScanMatchesBytewise() {
+    // , ,      127,   char
+    const std::string alphabet = "  abc-\x7f\x80\xe0\xff"s + std::string(1, '\0') + "\x01\x1f"s;
+    std::mt19937 generator(42);
+    std::vector<std::string_view> words;
+    for (int iteration = 0; iteration < 100'000; ++iteration) {
+        const size_t size = generator() % 200;
+        const size_t offset = generator() % 16;
+        //   ,       
+        const bool has_controls = generator() % 4 == 0;
+        std::string text;
+        for (size_t i = 0; i < size; ++i) {
+            const size_t letter = generator() % (has_controls ? alphabet.size() : alphabet.size() - 3);
+            text += alphabet[letter];
+        }
+        //     :      AddressSanitizer
+        const auto buffer = std::make_unique<char[]>(offset + size);
+        std::copy(text.begin(), text.end(), buffer.get() + offset);
+        const std::string_view view(buffer.get() + offset, size);
+
+        const auto expected_control = std::find_if(text.begin(), text.end(), [](char c) {
+            return c >= '\0' && c < ' ';
+        });
+        const size_t expected_position = expected_control == text.end()
+            ? std::string_view::npos : static_cast<size_t>(expected_control - text.begin());
+        const size_t first_control = SplitIntoWords(view, words);
+        ASSERT_EQUAL(first_control, expected_position);
+        ASSERT_EQUAL(FindControlChar(view), expected_position);
+        ASSERT(std::vector<std::string>(words.begin(), words.end()) == SplitIntoWords(text));
+    }
+}
+
+void TestResultCacheEviction() {
+    ResultCache cache(1);
+    cache.SetCapacity(3);
+    ASSERT(cache.IsEnabled());
+    const std::vector<Document> documents = { { 1, 0.5, 3 }, { 2, 0.25, 1 } };
+    cache.Insert("a"s, 1, documents);
+    cache.Insert("b"s, 1, documents);
+    cache.Insert("c"s, 1, documents);
+    std::vector<Document> found;
+    ASSERT(cache.Find("a"s, 1, found));
+    ASSERT_EQUAL(found.size(), 2u);
+    ASSERT_EQUAL(found[1].id, 2);
+
+    //     b
+    cache.Insert("d"s, 1, documents);
+    ASSERT(!cache.Find("b"s, 1, found));
+    ASSERT(cache.Find("a"s, 1, found));
+    ASSERT(cache.Find("c"s, 1, found));
+    ASSERT(cache.Find("d"s, 1, found));
+    ResultCache::Stats stats = cache.GetStats();
+    ASSERT_EQUAL(stats.insertions, 4u);
+    ASSERT_EQUAL(stats.evictions, 1u);
+    ASSERT_EQUAL(stats.hits, 4u);
+    ASSERT_EQUAL(stats.misses, 1u);
+    ASSERT_EQUAL(stats.entry_count, 3u);
+
+    //      
+    ASSERT(!cache.Find("a"s, 2, found));
+    stats = cache.GetStats();
+    ASSERT_EQUAL(stats.invalidations, 1u);
+    ASSERT_EQUAL(stats.entry_count, 2u);
+
+    //      
+    cache.SetCapacity(1);
+    ASSERT_EQUAL(cache.GetStats().entry_count, 1u);
+    ASSERT(cache.Find("d"s, 1, found));
+
+    cache.SetCapacity(0);
+    ASSERT(!cache.IsEnabled());
+    ASSERT_EQUAL(cache.GetStats().entry_count, 0u);
+    cache.Insert("e"s, 1, documents);
+    ASSERT_EQUAL(cache.GetStats().entry_count, 0u);
+    ASSERT_EQUAL(cache.GetStats().memory_bytes, 0u);
+}
+
+void TestSearchResultCache() {
+    SearchServer server("and with"s);
+    server.SetResultCacheCapacity(100);
+    server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::BANNED, { 5, -12, 2, 1 });
+    const std::string query = "fluffy groomed cat"s;
+    const auto get_ids = [](const std::vector<Document>& documents) {
+        std::vector<int> ids;
+        for (const Document& document : documents) {
+            ids.push_back(document.id);
+        }
+        return ids;
+    };
+
+    const std::vector<Document> first = server.FindTopDocuments(query);
+    const std::vector<Document> second = server.FindTopDocuments(query);
+    ASSERT(get_ids(second) == get_ids(first));
+    ASSERT(get_ids(first) == std::vector<int>({ 2, 1 }));
+    ResultCache::Stats stats = server.GetResultCacheStats();
+    ASSERT_EQUAL(stats.hits, 1u);
+    ASSERT_EQUAL(stats.misses, 1u);
+    //       
+    ASSERT(get_ids(server.FindTopDocuments(query, DocumentStatus::BANNED)) == std::vector<int>({ 3 }));
+    server.SetMaxResultDocumentCount(1);
+    ASSERT(get_ids(server.FindTopDocuments(query)) == std::vector<int>({ 2 }));
+    server.SetMaxResultDocumentCount(MAX_RESULT_DOCUMENT_COUNT);
+    ASSERT_EQUAL(server.GetResultCacheStats().misses, 3u);
+
+    server.AddDocument(4, "fluffy groomed cat"s, DocumentStatus::ACTUAL, { 1 });
+    ASSERT(get_ids(server.FindTopDocuments(query)) == std::vector<int>({ 4, 2, 1 }));
+    ASSERT_EQUAL(server.GetResultCacheStats().invalidations, 1u);
+    server.RemoveDocument(2);
+    ASSERT(get_ids(server.FindTopDocuments(query)) == std::vector<int>({ 4, 1 }));
+    ASSERT_EQUAL(server.GetResultCacheStats().invalidations, 2u);
+
+    //       
+    std::vector<std::string> texts;
+    for (int i = 0; i < 40; ++i) {
+        texts.push_back("cat number"s + std::to_string(i));
+    }
+    for (int batch = 0; batch < 4; ++batch) {
+        std::vector<NewDocument> documents;
+        for (int i = 0; i < 10; ++i) {
+            documents.push_back({ 100 + batch * 10 + i, texts[batch * 10 + i], DocumentStatus::ACTUAL, { 0 } });
+        }
+        server.AddDocuments(documents);
+    }
+    const std::vector<Document> before_merge = server.FindTopDocuments(query);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const uint64_t hits = server.GetResultCacheStats().hits;
+    ASSERT(get_ids(server.FindTopDocuments(query)) == get_ids(before_merge));
+    ASSERT_EQUAL(server.GetResultCacheStats().hits, hits + 1);
+
+    server.SetResultCacheCapacity(0);
+    stats = server.GetResultCacheStats();
+    ASSERT_EQUAL(stats.entry_count, 0u);
+    ASSERT(get_ids(server.FindTopDocuments(query)) == get_ids(before_merge));
+    ASSERT_EQUAL(server.GetResultCacheStats().hits, stats.hits);
+    ASSERT_EQUAL(server.GetResultCacheStats().misses, stats.misses);
+}
+
+void TestRequestQueueWindow() {
+    SearchServer server("and with"s);
+    server.AddDocument(1, "fluffy cat"s, DocumentStatus::ACTUAL, { 7 });
+    server.AddDocument(2, "groomed dog"s, DocumentStatus::BANNED, { 5 });
+
+    //  : 0 -  ACTUAL, 1 -  ACTUAL, 2 - BANNED, 3 - 
+    RequestQueue queue(server);
+    std::deque<std::pair<int, bool>> window;
+    for (int i = 0; i < 3000; ++i) {
+        const int kind = i % 7 % 4;
+        bool is_empty = false;
+        switch (kind) {
+        case 0:
+            is_empty = queue.AddFindRequest("cat"s).empty();
+            break;
+        case 1:
+            is_empty = queue.AddFindRequest("starling"s).empty();
+            break;
+        case 2:
+            is_empty = queue.AddFindRequest("dog"s, DocumentStatus::BANNED).empty();
+            break;
+        default:
+            is_empty = queue.AddFindRequest("cat dog"s, [](int, DocumentStatus, int rating) {
+                return rating > 6;
+                }).empty();
+        }
+        ASSERT_EQUAL(is_empty, kind == 1);
+        window.emplace_back(kind, is_empty);
+        if (window.size() > 1440) {
+            window.pop_front();
+        }
+        const auto count_kind = [&window](int expected_kind) {
+            return static_cast<int>(std::count_if(window.begin(), window.end(), [expected_kind](const auto& request) {
+                return request.first == expected_kind;
+                }));
+        };
+        ASSERT_EQUAL(queue.TotalRequets(), static_cast<int>(window.size()));
+        ASSERT_EQUAL(queue.GetNoResultRequests(), count_kind(1));
+        ASSERT_EQUAL(queue.GetStatusRequests(DocumentStatus::ACTUAL), count_kind(0) + count_kind(1));
+        ASSERT_EQUAL(queue.GetStatusRequests(DocumentStatus::BANNED), count_kind(2));
+        ASSERT_EQUAL(queue.GetStatusRequests(DocumentStatus::IRRELEVANT), 0);
+        ASSERT_EQUAL(queue.GetPredicateRequests(), count_kind(3));
+    }
+
+    //     ;    ,  
+    RequestQueue concurrent_queue(server);
+    const auto add_requests = [&concurrent_queue](int thread_count, int request_count) {
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < thread_count; ++thread) {
+            threads.emplace_back([&concurrent_queue, thread, request_count] {
+                for (int i = 0; i < request_count; ++i) {
+                    if (thread % 2 == 0) {
+                        concurrent_queue.AddFindRequest("starling"s);
+                    }
+                    else {
+                        concurrent_queue.AddFindRequest("dog"s, DocumentStatus::BANNED);
+                    }
+                }
+                });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    };
+    add_requests(4, 300);
+    ASSERT_EQUAL(concurrent_queue.TotalRequets(), 1200);
+    ASSERT_EQUAL(concurrent_queue.GetNoResultRequests(), 600);
+    ASSERT_EQUAL(concurrent_queue.GetStatusRequests(DocumentStatus::ACTUAL), 600);
+    ASSERT_EQUAL(concurrent_queue.GetStatusRequests(DocumentStatus::BANNED), 600);
+    //           
+    add_requests(4, 500);
+    ASSERT_EQUAL(concurrent_queue.TotalRequets(), 1440);
+    ASSERT_EQUAL(concurrent_queue.GetNoResultRequests(), concurrent_queue.GetStatusRequests(DocumentStatus::ACTUAL));
+    ASSERT_EQUAL(concurrent_queue.GetStatusRequests(DocumentStatus::ACTUAL)
+        + concurrent_queue.GetStatusRequests(DocumentStatus::BANNED), 1440);
+}
+
+void TestLatencyHistogramAndMetrics() {
+    //         
+    const auto get_upper_bound = [](uint64_t value) {
+        LatencyHistogram histogram;
+        histogram.Add(value);
+        return histogram.GetValueAtQuantile(1.0);
+    };
+    for (uint64_t value = 0; value < LatencyHistogram::SUB_BUCKET_COUNT; ++value) {
+        ASSERT_EQUAL(get_upper_bound(value), value);
+    }
+    for (int bits = LatencyHistogram::SUB_BUCKET_BITS; bits < LatencyHistogram::MAX_VALUE_BITS; ++bits) {
+        const uint64_t power = uint64_t{ 1 } << bits;
+        const uint64_t bucket_width = power >> LatencyHistogram::SUB_BUCKET_BITS;
+        const std::string hint = "2^"s + std::to_string(bits);
+        ASSERT_EQUAL_HINT(get_upper_bound(power - 1), power - 1, hint);
+        ASSERT_EQUAL_HINT(get_upper_bound(power), power + bucket_width - 1, hint);
+        ASSERT_EQUAL_HINT(get_upper_bound(power + bucket_width - 1), power + bucket_width - 1, hint);
+        ASSERT_EQUAL_HINT(get_upper_bound(power + bucket_width), power + 2 * bucket_width - 1, hint);
+        ASSERT_EQUAL_HINT(get_upper_bound(2 * power - 1), 2 * power - 1, hint);
+    }
+    const uint64_t max_bound = (uint64_t{ 1 } << LatencyHistogram::MAX_VALUE_BITS) - 1;
+    ASSERT_EQUAL(get_upper_bound(max_bound + 1), max_bound);
+    ASSERT_EQUAL(get_upper_bound(uint64_t{ 1 } << 50), max_bound);
+    ASSERT_EQUAL(get_upper_bound(std::numeric_limits<uint64_t>::max()), max_bound);
+
+    //  -      ceil(quantile * count)
+    LatencyHistogram histogram;
+    ASSERT_EQUAL(histogram.GetValueAtQuantile(0.5), 0u);
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        histogram.Add(value);
+    }
+    ASSERT_EQUAL(histogram.GetCount(), 1000u);
+    ASSERT_EQUAL(histogram.GetSum(), 500500u);
+    ASSERT_EQUAL(histogram.GetValueAtQuantile(0.0), 1u);
+    ASSERT_EQUAL(histogram.GetValueAtQuantile(0.5), 511u);
+    ASSERT_EQUAL(histogram.GetValueAtQuantile(0.99), 991u);
+    ASSERT_EQUAL(histogram.GetValueAtQuantile(1.0), 1023u);
+    LatencyHistogram merged;
+    merged.Add(max_bound + 1);
+    merged.Merge(histogram);
+    ASSERT_EQUAL(merged.GetCount(), 1001u);
+    ASSERT_EQUAL(merged.GetValueAtQuantile(0.5), 511u);
+    ASSERT_EQUAL(merged.GetValueAtQuantile(1.0), max_bound);
+    merged.Clear();
+    ASSERT_EQUAL(merged.GetCount(), 0u);
+    ASSERT_EQUAL(merged.GetSum(), 0u);
+    ASSERT_EQUAL(merged.GetValueAtQuantile(1.0), 0u);
+
+    //       
+    QueryMetrics metrics;
+    for (uint64_t value = 1; value <= 1000; ++value) {
+        QueryMetrics::Sample sample;
+        sample.Start();
+        sample.phase_nanoseconds[static_cast<size_t>(QueryMetrics::Phase::PARSE)] = value;
+        sample.measured_phases = uint32_t{ 1 } << static_cast<size_t>(QueryMetrics::Phase::PARSE);
+        sample.postings_scanned = 3;
+        sample.documents_scored = 2;
+        sample.documents_filtered = 1;
+        metrics.Record(sample, 5);
+    }
+    QueryMetrics::Snapshot snapshot = metrics.GetSnapshot();
+    const QueryMetrics::PhaseStats& parse = snapshot.GetPhase(QueryMetrics::Phase::PARSE);
+    ASSERT_EQUAL(parse.count, 1000u);
+    ASSERT_EQUAL(parse.mean.count(), 500);
+    ASSERT_EQUAL(parse.p50.count(), 511);
+    ASSERT_EQUAL(parse.p99.count(), 991);
+    ASSERT_EQUAL(parse.p999.count(), 1023);
+    ASSERT_EQUAL(snapshot.GetPhase(QueryMetrics::Phase::RESOLVE).count, 0u);
+    ASSERT_EQUAL(snapshot.GetPhase(QueryMetrics::Phase::TOTAL).count, 1000u);
+    ASSERT_EQUAL(snapshot.query_count, 1000u);
+    ASSERT_EQUAL(snapshot.postings_scanned, 3000u);
+    ASSERT_EQUAL(snapshot.documents_scored, 2000u);
+    ASSERT_EQUAL(snapshot.documents_filtered, 1000u);
+    ASSERT_EQUAL(snapshot.documents_returned, 5000u);
+    metrics.Clear();
+    snapshot = metrics.GetSnapshot();
+    ASSERT_EQUAL(snapshot.query_count, 0u);
+    ASSERT_EQUAL(snapshot.GetPhase(QueryMetrics::Phase::PARSE).count, 0u);
+    ASSERT_EQUAL(snapshot.GetPhase(QueryMetrics::Phase::TOTAL).count, 0u);
+
+    //       ,      
+    SearchServer server("and with"s);
+    server.SetResultCacheCapacity(100);
+    server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    server.FindTopDocuments("warm-up"s);
+    server.ResetMetrics();
+    size_t returned_count = 0;
+    for (const std::string& query : { "cat"s, "dog"s, "cat"s, "starling"s }) {
+        returned_count += server.FindTopDocuments(query).size();
+    }
+    returned_count += server.FindTopDocuments("fluffy dog"s, [](int, DocumentStatus, int rating) {
+        return rating > 4;
+        }).size();
+    snapshot = server.GetMetrics();
+    ASSERT_EQUAL(snapshot.query_count, 5u);
+    ASSERT_EQUAL(snapshot.documents_returned, returned_count);
+    ASSERT_EQUAL(returned_count, 6u);
+    const std::pair<QueryMetrics::Phase, uint64_t> expected_counts[] = {
+        { QueryMetrics::Phase::PARSE, 5 },
+        { QueryMetrics::Phase::RESOLVE, 4 },
+        { QueryMetrics::Phase::TRAVERSE, 4 },
+        { QueryMetrics::Phase::TOP_K, 4 },
+        { QueryMetrics::Phase::TOTAL, 5 },
+    };
+    for (const auto& [phase, count] : expected_counts) {
+        const QueryMetrics::PhaseStats& stats = snapshot.GetPhase(phase);
+        const std::string hint(QueryMetrics::GetPhaseName(phase));
+        ASSERT_EQUAL_HINT(stats.count, count, hint);
+        ASSERT_HINT(stats.p50 <= stats.p99 && stats.p99 <= stats.p999, hint);
+        ASSERT_HINT(stats.mean <= stats.p999, hint);
+    }
+    const QueryMetrics::PhaseStats& total = snapshot.GetPhase(QueryMetrics::Phase::TOTAL);
+    ASSERT(total.p50 > std::chrono::nanoseconds::zero());
+    ASSERT(total.p999 >= snapshot.GetPhase(QueryMetrics::Phase::PARSE).p999);
+    server.ResetMetrics();
+    ASSERT_EQUAL(server.GetMetrics().query_count, 0u);
+    ASSERT_EQUAL(server.GetMetrics().GetPhase(QueryMetrics::Phase::TOTAL).count, 0u);
+}
+
+void TestProfiler() {
+    using namespace std::chrono_literals;
+    Profiler::Reset();
+    const std::string zone_name = "TestProfiler \"zone\" \\ 1"s;
+    const size_t zone = Profiler::RegisterZone(zone_name, "unit_tests.cpp", 1);
+    ASSERT_EQUAL(Profiler::RegisterZone(zone_name, "unit_tests.cpp", 1), zone);
+    ASSERT(Profiler::RegisterZone("TestProfiler other zone", "unit_tests.cpp", 1) != zone);
+
+    //      
+    const Profiler::Clock::time_point start_time = Profiler::Clock::now();
+    Profiler::Record(zone, start_time, start_time + 100ns);
+    Profiler::Record(zone, start_time, start_time + 300ns);
+    Profiler::Record(zone, start_time, start_time + 200ns);
+    std::thread([zone, start_time] {
+        Profiler::Record(zone, start_time, start_time + 50ns);
+        Profiler::Record(zone, start_time, start_time + 1000ns);
+        }).join();
+    std::optional<Profiler::ZoneStats> stats = FindZoneStats(zone_name);
+    ASSERT(stats.has_value());
+    ASSERT_EQUAL(stats->count, 5u);
+    ASSERT_EQUAL(stats->total.count(), 1650);
+    ASSERT_EQUAL(stats->min.count(), 50);
+    ASSERT_EQUAL(stats->max.count(), 1000);
+    ASSERT_EQUAL(stats->file, "unit_tests.cpp"s);
+    ASSERT_EQUAL(stats->line, 1);
+    ASSERT(!FindZoneStats("TestProfiler other zone").has_value());
+    std::ostringstream report;
+    Profiler::PrintReport(report);
+    ASSERT_EQUAL(CountOccurrences(report.str(), zone_name), 1u);
+
+    Profiler::Reset();
+    ASSERT(!FindZoneStats(zone_name).has_value());
+    Profiler::Record(zone, start_time, start_time + 70ns);
+    stats = FindZoneStats(zone_name);
+    ASSERT(stats.has_value());
+    ASSERT_EQUAL(stats->count, 1u);
+    ASSERT_EQUAL(stats->min.count(), 70);
+
+    //           StopTrace
+    Profiler::StartTrace(3);
+    const Profiler::Clock::time_point trace_time = Profiler::Clock::now();
+    for (int i = 0; i < 5; ++i) {
+        Profiler::Record(zone, trace_time + i * 1us, trace_time + i * 1us + 1500ns);
+    }
+    Profiler::StopTrace();
+    Profiler::Record(zone, trace_time, trace_time + 1ns);
+    std::ostringstream trace;
+    Profiler::WriteTrace(trace);
+    const std::string trace_text = trace.str();
+    ASSERT_EQUAL(trace_text.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["s, 0), 0u);
+    ASSERT_EQUAL(trace_text.substr(trace_text.size() - 4), "\n]}\n"s);
+    ASSERT_EQUAL(CountOccurrences(trace_text, "\"ph\":\"X\""), 3u);
+    ASSERT_EQUAL(CountOccurrences(trace_text, "\"name\":\"TestProfiler \\\"zone\\\" \\\\ 1\""), 3u);
+    ASSERT_EQUAL(CountOccurrences(trace_text, "\"dur\":1.500}"), 3u);
+    ASSERT_EQUAL(FindZoneStats(zone_name)->count, 7u);
+    Profiler::Reset();
+    std::ostringstream empty_trace;
+    Profiler::WriteTrace(empty_trace);
+    ASSERT_EQUAL(CountOccurrences(empty_trace.str(), "\"ph\""), 0u);
+
+#ifdef SEARCH_SERVER_PROFILE
+    //  PROFILE_SCOPE       
+    for (int i = 0; i < 4; ++i) {
+        PROFILE_SCOPE("TestProfiler loop");
+    }
+    SearchServer server("and with"s);
+    server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    server.RemoveDocument(1);
+    server.FindTopDocuments("fluffy cat"s);
+    const std::pair<std::string_view, uint64_t> expected_counts[] = {
+        { "TestProfiler loop", 4 },
+        { "SearchServer::AddDocument", 2 },
+        { "SearchServer::RemoveDocument", 1 },
+        { "SearchServer::FindTopDocumentsPruned", 1 },
+    };
+    for (const auto& [name, count] : expected_counts) {
+        stats = FindZoneStats(name);
+        ASSERT_HINT(stats.has_value(), std::string(name));
+        ASSERT_EQUAL_HINT(stats->count, count, std::string(name));
+        ASSERT_HINT(stats->min <= stats->max && stats->max <= stats->total, std::string(name));
+    }
+    Profiler::Reset();
+#endif
+}
+
+void TestBatchExecutorStress() {
+    BatchExecutor executor(4);
+
+    //    8      1-3     ,
+    //      :  31 ,       Run
+    const size_t tasks_per_batch = 31;
+    const int thread_count = 4;
+    const int round_count = 500;
+    std::atomic<bool> is_incomplete = false;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < thread_count; ++thread) {
+        threads.emplace_back([&executor, &is_incomplete] {
+            std::atomic<size_t> executed_count = 0;
+            for (int round = 0; round < round_count; ++round) {
+                executor.Run(8, [&executor, &executed_count](size_t i) {
+                    executor.Run(i % 3 + 1, [&executed_count](size_t) {
+                        executed_count.fetch_add(1, std::memory_order_relaxed);
+                        });
+                    executor.Spawn([&executor, &executed_count] {
+                        executed_count.fetch_add(1, std::memory_order_relaxed);
+                        executor.Spawn([&executed_count] {
+                            executed_count.fetch_add(1, std::memory_order_relaxed);
+                            });
+                        });
+                    });
+                if (executed_count.load() != (round + 1) * tasks_per_batch) {
+                    is_incomplete = true;
+                }
+            }
+            });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    ASSERT(!is_incomplete);
+
+    //   ,         Run
+    const auto get_error = [&executor](const std::function<void(size_t)>& task) {
+        try {
+            executor.Run(100, task);
+        }
+        catch (const std::runtime_error& error) {
+            return std::string(error.what());
+        }
+        return ""s;
+    };
+    ASSERT_EQUAL(get_error([](size_t i) {
+        if (i == 37) {
+            throw std::runtime_error("task"s);
+        }
+        }), "task"s);
+    ASSERT_EQUAL(get_error([&executor](size_t i) {
+        executor.Run(4, [i](size_t j) {
+            if (i == 50 && j == 3) {
+                throw std::runtime_error("nested"s);
+            }
+            });
+        }), "nested"s);
+    ASSERT_EQUAL(get_error([&executor](size_t i) {
+        if (i == 99) {
+            executor.Spawn([] {
+                throw std::runtime_error("spawned"s);
+                });
+        }
+        }), "spawned"s);
+
+    //    ,  Spawn     
+    std::atomic<size_t> executed_count = 0;
+    executor.Run(1000, [&executed_count](size_t) {
+        executed_count.fetch_add(1, std::memory_order_relaxed);
+        });
+    ASSERT_EQUAL(executed_count.load(), 1000u);
+    const auto is_spawn_rejected = [&executor] {
+        try {
+            executor.Spawn([] {});
+        }
+        catch (const std::logic_error&) {
+            return true;
+        }
+        return false;
+    };
+    ASSERT(is_spawn_rejected());
+    BatchExecutor other_executor(2);
+    std::atomic<bool> is_rejected_in_other = false;
+    other_executor.Run(1, [&is_spawn_rejected, &is_rejected_in_other](size_t) {
+        is_rejected_in_other = is_spawn_rejected();
+        });
+    ASSERT(is_rejected_in_other);
+}
+
+void TestSplitQueriesMatchFindTopDocuments() {
+    //      SPLIT_QUERY_POSTING_COUNT ;
+    //       
+    const int document_count = 50000;
+    std::mt19937 generator(25);
+    std::uniform_int_distribution<int> repeat_distribution(1, 3);
+    std::uniform_int_distribution<int> filler_distribution(0, 20);
+    std::uniform_int_distribution<int> word_distribution(0, 999);
+    std::vector<std::string> texts;
+    texts.reserve(document_count);
+    for (int document_id = 0; document_id < document_count; ++document_id) {
+        std::string text = "cat"s;
+        for (int repeat = repeat_distribution(generator); document_id % 2 == 0 && repeat > 0; --repeat) {
+            text += " dog"s;
+        }
+        for (int repeat = repeat_distribution(generator); document_id % 3 == 0 && repeat > 0; --repeat) {
+            text += " parrot"s;
+        }
+        for (int filler = filler_distribution(generator); filler > 0; --filler) {
+            text += " word"s + std::to_string(word_distribution(generator));
+        }
+        texts.push_back(std::move(text));
+    }
+    SearchServer server("and with"s);
+    std::vector<NewDocument> documents;
+    for (int document_id = 0; document_id < 40000; ++document_id) {
+        documents.push_back({ document_id, texts[document_id], DocumentStatus::ACTUAL, { document_id % 11 - 5 } });
+    }
+    server.AddDocuments(documents);
+    for (int document_id = 40000; document_id < document_count; ++document_id) {
+        server.AddDocument(document_id, texts[document_id], document_id % 7 == 0 ? DocumentStatus::BANNED
+            : DocumentStatus::ACTUAL, { document_id % 11 - 5 });
+    }
+    for (int document_id = 5; document_id < document_count; document_id += 10) {
+        server.RemoveDocument(document_id);
+    }
+
+    const std::vector<std::string> queries = {
+        "cat dog parrot"s, "cat dog -parrot"s, "cat parrot word7"s, "dog parrot -word1"s, "word1 word2"s,
+    };
+    const SearchServer::PreparedQuery heavy_query = server.PrepareQuery(queries[0]);
+    ASSERT(heavy_query.GetPostingCount() > SPLIT_QUERY_POSTING_COUNT);
+    ASSERT(server.SplitQuery(heavy_query, SPLIT_QUERY_POSTING_COUNT).size() > 1);
+
+    BatchExecutor executor(4);
+    for (const size_t max_document_count : { 1u, 5u, 50u }) {
+        server.SetMaxResultDocumentCount(max_document_count);
+        const std::vector<std::vector<Document>> processed = ProcessQueries(server, queries, executor);
+        ASSERT_EQUAL(processed.size(), queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            AssertSameTopDocuments(server.FindTopDocuments(queries[i]), processed[i], max_document_count, queries[i]);
+        }
+    }
+}
+
+void TestSearchComponents() {
+    RUN_TEST(TestPrunedSearchMatchesExhaustive);
+    RUN_TEST(TestReadsDuringWrites);
+    RUN_TEST(TestCompactStorage);
+    RUN_TEST(TestBlockScanMatchesBytewise);
+    RUN_TEST(TestResultCacheEviction);
+    RUN_TEST(TestSearchResultCache);
+    RUN_TEST(TestRequestQueueWindow);
+    RUN_TEST(TestLatencyHistogramAndMetrics);
+    RUN_TEST(TestProfiler);
+    RUN_TEST(TestBatchExecutorStress);
+    RUN_TEST(TestSplitQueriesMatchFindTopDocuments);
+    std::cout << "Search components testing finished"s << std::endl;
+}
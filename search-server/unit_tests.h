@@ -46,4 +46,91 @@ void TestRemoveDuplicates();
 void TestSearchServer();
 
 
-*/
\ No newline at end of file
+*/
+
+#include "search_server.h"
+
+#include <string>
+#include <vector>
+
+//           ,  
+void TestIndexFileRoundTrip();
+
+// ,    ,    
+void TestOperationLogReplay();
+
+//      ,     
+void TestOperationLogTruncatedTail();
+
+//          ,
+//         
+void TestCheckpointRecovery();
+
+// ,        ,     
+void TestReAddRemovedDocument();
+
+//    ,     ,
+//    ,   ,   
+void TestSegmentMergeWithTombstones();
+
+//         
+//    
+void TestPostingBlockDecoding();
+
+//       ,   ,   
+void TestCompressedSegmentSearch();
+
+//     QueryContext   
+void TestQueryContextAllocations();
+
+//            
+void TestMappedTermDictionaryValidation();
+
+//   :  ,  , ,  
+void TestIndexStorage();
+
+//          ,  
+//    ProcessQueries,  -,    
+void TestPrunedSearchMatchesExhaustive();
+
+//  ,        , ,
+//   CompactStorage     
+void TestReadsDuringWrites();
+
+// CompactStorage        
+//     
+void TestCompactStorage();
+
+//           ,  ,
+//        
+void TestBlockScanMatchesBytewise();
+
+//       ,  
+//      
+void TestResultCacheEviction();
+
+//     ,     
+//  ,    - 
+void TestSearchResultCache();
+
+//         1440 ,
+//            
+void TestRequestQueueWindow();
+
+//          ,
+//        
+void TestLatencyHistogramAndMetrics();
+
+//  ,    ,   
+//  SEARCH_SERVER_PROFILE -    PROFILE_SCOPE   
+void TestProfiler();
+
+//     :    ,
+//     
+void TestBatchExecutorStress();
+
+//  ProcessQueries        FindTopDocuments
+void TestSplitQueriesMatchFindTopDocuments();
+
+//     :  , , ,  
+void TestSearchComponents();